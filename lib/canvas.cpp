@@ -9,81 +9,128 @@ namespace life {
 
   // TODO: Adicione o resto da implementação dos métodos aqui.
 
-  Canvas::Canvas(size_t w, size_t h, short bs){
+  Canvas::Canvas(size_t w, size_t h, short bs, PixelFormat format){
     m_width = w;
     m_height = h;
     m_block_size = bs;
+    m_format = format;
 
-    m_pixels.resize(w*h*4);
+    m_pixels.resize(width()*height()*depth());
   }
 
   //=== Members
   /// Clear the canvas with black color.
   void Canvas::clear(const Color& color){
-    for(size_t i{0u}; i < m_pixels.size(); i+=4){
-      m_pixels[i] = color.channels[Color::R];
-      m_pixels[i+1] = color.channels[Color::G];
-      m_pixels[i+2] = color.channels[Color::B];
-      m_pixels[i+3] = 255;
+    fill(0, width()*height(), color);
+  }
+  /// Clear only a rectangle of the canvas, given in virtual pixels.
+  void Canvas::clear(const Color& color, coord_t x, coord_t y, size_t w, size_t h){
+    if(x >= m_width) return;
+    w = std::min(w, m_width - x);
+    for(size_t row{y}; row < y + h and row < m_height; row++){
+      fill(row*m_block_size*width() + x*m_block_size, w*m_block_size, color);
+      copy_block_rows(row, x, x + w - 1);
     }
   }
   /// Set the color of a pixel on the canvas.
   void Canvas::pixel(coord_t x, coord_t y, const Color& color){
+    clear(color, x, y, 1, 1);
+  }
 
-    long index = getIndexOfRow(y) + getIndexOfColumn(x);
-    // index += a;
-    // index += b;
-    m_pixels[index] = color.channels[Color::R];
-    m_pixels[index+1] = color.channels[Color::G];
-    m_pixels[index+2] = color.channels[Color::B];
-    m_pixels[index+3] = 255;
+  /*!
+   * The row is drawn as runs of equal cells, found a word at a time with
+   * count-trailing-zeros, and each run is a single fill. Only the first
+   * real row is drawn; the others of the block are copies of it.
+   */
+  void Canvas::draw_bits(coord_t y, const uint64_t* bits, coord_t first, coord_t last, const Color& off, const Color& on){
+    if(y >= m_height or first >= m_width) return;
+    last = std::min(last, coord_t(m_width - 1));
+    const size_t row_start = y*m_block_size*width();
+    for(size_t col{first}; col <= last;){
+      uint64_t word = bits[col/64] >> (col%64);
+      bool alive = word & 1;
+      // Cells left in this word with the same state (the bits shifted in are zeros).
+      uint64_t changes = alive ? ~word : word;
+      size_t run = changes ? __builtin_ctzll(changes) : 64 - col%64;
+      run = std::min({run, 64 - col%64, last + 1 - col});
+      fill(row_start + col*m_block_size, run*m_block_size, alive ? on : off);
+      col += run;
+    }
+    copy_block_rows(y, first, last);
   }
 
-  /// Get the pixel color from the canvas.
-  Color Canvas::pixel(coord_t x, coord_t y){
-    size_t row = getIndexOfRow(y);
-    size_t column = getIndexOfColumn(x);
+  /// Each index is set over its block of the first real row, which is then copied over the rest of the block.
+  void Canvas::draw_indices(coord_t y, const component_t* indices){
+    if(y >= m_height or m_format != PixelFormat::INDEXED or m_width == 0) return;
+    component_t* out = &m_pixels[getIndexOfRow(y)];
+    for(size_t x{0u}; x < m_width; x++, out += m_block_size){
+      std::memset(out, indices[x], m_block_size);
+    }
+    copy_block_rows(y, 0, m_width - 1);
+  }
 
-    return Color(m_pixels[row+column], m_pixels[row+column+1], m_pixels[row+column+2]);
+  void Canvas::copy_block_rows(coord_t y, coord_t first, coord_t last){
+    const size_t d = depth(), row_bytes = width()*d;
+    const size_t start = getIndexOfRow(y) + getIndexOfColumn(first), bytes = (last + 1 - first)*m_block_size*d;
+    for(int j{1}; j < m_block_size; j++){
+      std::memcpy(&m_pixels[start + j*row_bytes], &m_pixels[start], bytes);
+    }
+  }
+
+  /// Writes the stored representation of a color. Colors missing from the palette of an indexed canvas are added to it.
+  void Canvas::encode(const Color& color, component_t* out){
+    if(m_format == PixelFormat::INDEXED){
+      size_t index{0};
+      while(index < m_palette.size() and std::memcmp(m_palette[index].channels, color.channels, 3) != 0) index++;
+      if(index == m_palette.size()){
+        if(index == 256) throw std::length_error("Canvas palette is full");
+        m_palette.push_back(color);
+      }
+      out[0] = component_t(index);
+      return;
+    }
+    out[0] = color.channels[Color::R];
+    out[1] = color.channels[Color::G];
+    out[2] = color.channels[Color::B];
+    if(m_format == PixelFormat::RGBA) out[3] = 255;
+  }
+
+  /// The first pixel is encoded once, then the filled part is copied over the rest, doubling each time, so the copies are done by memcpy (or memset, for indices).
+  void Canvas::fill(size_t first, size_t count, const Color& color){
+    if(count == 0) return;
+    const size_t d = depth(), bytes = count*d;
+    component_t* out = &m_pixels[first*d];
+    encode(color, out);
+    if(d == 1){
+      std::memset(out, out[0], count);
+      return;
+    }
+    for(size_t done{d}; done < bytes; done *= 2){
+      std::memcpy(out + done, out, std::min(done, bytes - done));
+    }
+  }
+
+  /// Get the pixel color from the canvas.
+  Color Canvas::pixel(coord_t x, coord_t y) const {
+    const component_t* in = &m_pixels[getIndexOfRow(y) + getIndexOfColumn(x)];
+    if(m_format == PixelFormat::INDEXED) return m_palette.at(in[0]);
+    return Color(in[0], in[1], in[2]);
   }
 
   /// @brief Get the index of m_pixels representing the starting position of a given row.
   /// @brief It is used alongside getIndexOfColumn, since getIndexOfRow(x) + getIndexOfColumn(y) returns the true position (x, y).
   /// @param row The position of the row you wanna get the index of. 
   /// @return The index of m_pixels's row.
-  size_t Canvas::getIndexOfRow(size_t row){
-    return m_width * 4 * row;
+  size_t Canvas::getIndexOfRow(size_t row) const {
+    return width() * depth() * m_block_size * row;
   }
 
   /// @brief Get the index of m_pixel representing the starting position of a given column.
   /// @brief It is used alongside getIndexOfRow, since getIndexOfRow(x) + getIndexOfColumn(y) returns the true position (x, y).
   /// @param column The position of the column you wanna get the index of. 
   /// @return The index of m_pixels's column.
-  size_t Canvas::getIndexOfColumn(size_t column){
-    return 4 * column;
-  }
-
-  /// @brief Scale the pixels from m_pixels into m_resized_pixels.
-  void Canvas::resize_pixels(){
-    m_resized_pixels.clear();
-    // Explanation: For each row in m_pixels, add each pixel of the row m_block_size
-    // times in m_resized_pixels. Then, repeat the process m_block_size times, then go to the next row. 
-    for(size_t i{0}; i < m_height; i++){
-      size_t row = getIndexOfRow(i);
-      for(int j{0u}; j < m_block_size; j++){
-        for(size_t k{0}; k < m_width; k++){
-          size_t column = getIndexOfColumn(k);
-          for(int l{0u}; l < m_block_size; l++){
-            m_resized_pixels.push_back(m_pixels[row+column]);
-            m_resized_pixels.push_back(m_pixels[row+column+1]);
-            m_resized_pixels.push_back(m_pixels[row+column+2]);
-            m_resized_pixels.push_back(m_pixels[row+column+3]);
-          }
-        }
-      }
-    }
-
-    m_resized_pixels.shrink_to_fit();
+  size_t Canvas::getIndexOfColumn(size_t column) const {
+    return depth() * m_block_size * column;
   }
 
 }
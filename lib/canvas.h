@@ -7,12 +7,20 @@ using std::vector;
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 #include <cstdint>
 
 #include "common.h"
 
 namespace life {
 
+/// How the pixels of a Canvas are stored; the value is the number of bytes of each pixel.
+enum class PixelFormat : uint8_t {
+  RGBA = 4,   //!< Red, green, blue and an opaque alpha.
+  RGB24 = 3,  //!< Red, green and blue, packed.
+  INDEXED = 1 //!< An index into the palette of the canvas.
+};
+
 //! Provides methods for drawing on an image.
 /*!
  * This is a drawing area on which we shall draw a Life representation.
@@ -26,10 +34,16 @@ namespace life {
  * set when the canvas is instantiated.
  * 3. Because of 2, we have the `virtual` dimension (set by the client),
  * and the `real` dimension, which is w * pixel_size by h * pixel_size.
+ * Only the real pixels are stored, so the image is ready to be encoded
+ * at any time.
  *
  * This class returns to the client an image (object) representation
  * of the canvas, which might be stored by the client as a PPM or
  * PNG image file.
+ *
+ * 4. Pixels may be stored as RGBA, RGB24 or as 8-bit indices into a palette
+ * of up to 256 colors. With a palette, colors are only looked up when the
+ * image is encoded (see palette()).
  */
 class Canvas {
  public:
@@ -46,22 +60,39 @@ class Canvas {
    * @param w The canvas width in virtual pixels.
    * @param h The canvas height in virtual pixels.
    * @param bs The canvas block size in real pixels.
+   * @param format How the pixels are stored.
    */
-  Canvas(size_t w = 0, size_t h = 0, short bs = 4);
+  Canvas(size_t w = 0, size_t h = 0, short bs = 4, PixelFormat format = PixelFormat::RGBA);
   /// Destructor.
   ~Canvas(void) = default;
   /// Copy constructor.
   Canvas(const Canvas&) = default;
+  /// Move constructor.
+  Canvas(Canvas&&) = default;
   /// Assignment operator.
   Canvas& operator=(const Canvas&) = default;
+  /// Move assignment operator.
+  Canvas& operator=(Canvas&&) = default;
 
   //=== Members
   /// Clear the canvas with black color.
   void clear(const Color& = BLACK);
+  /// Clear only a rectangle of the canvas, given in virtual pixels.
+  void clear(const Color&, coord_t x, coord_t y, size_t w, size_t h);
   /// Set the color of a pixel on the canvas.
   void pixel(coord_t, coord_t, const Color&);
   /// Get the pixel color from the canvas.
-  Color pixel(coord_t, coord_t);
+  Color pixel(coord_t, coord_t) const;
+  /// Draws virtual row `y` from a row of 1-bit cells (64 per word): set bits get `on`, clear bits get `off`.
+  void draw_bits(coord_t y, const uint64_t* bits, coord_t first, coord_t last, const Color& off, const Color& on);
+  /// Draws virtual row `y` of an indexed canvas from one palette index per virtual pixel.
+  void draw_indices(coord_t y, const component_t* indices);
+  /// Set the palette of an indexed canvas; color `i` is stored as index `i`.
+  void set_palette(const vector<Color>& palette)
+  { m_palette = palette; }
+  /// Set the palette of an indexed canvas, taking over the storage of `palette`.
+  void set_palette(vector<Color>&& palette)
+  { m_palette = std::move(palette); }
 
   //=== Attribute accessors members.
   /// Get the canvas width.
@@ -73,24 +104,38 @@ class Canvas {
   /// Get the block size.
   size_t block_size() const
   { return m_block_size; }
-  /// Get the canvas pixels, as an array of `unsigned char`.
-  const component_t* pixels(void)
-  { resize_pixels(); return m_resized_pixels.data(); }
+  /// Get how the pixels are stored.
+  PixelFormat format(void) const
+  { return m_format; }
+  /// Get the bytes per pixel.
+  size_t depth(void) const
+  { return size_t(m_format); }
+  /// Get the palette of an indexed canvas.
+  const vector<Color>& palette(void) const
+  { return m_palette; }
+  /// Get the canvas pixels at real scale, as an array of `unsigned char` in the storage format.
+  const component_t* pixels(void) const
+  { return m_pixels.data(); }
 
   private:
-    /// Gets the position of the vector that represents the start of the given row.
-    size_t getIndexOfRow(size_t);
-    /// Gets the position of the vector that represents the start of the given column.
-    size_t getIndexOfColumn(size_t);
-    /// Gets the vector representing the resized pixels.
-    void resize_pixels(void);
+    /// Gets the position of the vector that represents the start of the given (virtual) row.
+    size_t getIndexOfRow(size_t) const;
+    /// Gets the position of the vector that represents the start of the given (virtual) column, inside a row.
+    size_t getIndexOfColumn(size_t) const;
+    /// Copies the first real row of virtual row `y`, between the given virtual columns, over the rest of its block.
+    void copy_block_rows(coord_t y, coord_t first, coord_t last);
+    /// Writes the stored representation of a color into `out` (depth() bytes).
+    void encode(const Color&, component_t* out);
+    /// Sets `count` real pixels from the given one (counted row by row) to a color.
+    void fill(size_t first, size_t count, const Color&);
 
   private:
     size_t m_width;                        //!< The image width in pixel units.
     size_t m_height;                       //!< The image height in pixel units.
     short m_block_size;                    //!< Cell size in pixels
-    vector<component_t> m_pixels;          //!< The pixels, stored as 3 RGB components.
-    vector<component_t> m_resized_pixels;  //!< The pixels at larger scale, stored as 3 RGB components.
+    PixelFormat m_format;                  //!< How the pixels are stored.
+    vector<Color> m_palette;               //!< Colors of the indices (INDEXED only).
+    vector<component_t> m_pixels;          //!< The real pixels, in the storage format.
     
 };
 }  // namespace life
@@ -37,7 +37,7 @@ struct Color {
     return *this;
   }
   /// Comparison operator.
-  bool operator==(const Color& rhs)
+  bool operator==(const Color& rhs) const
   {
     return not std::memcmp(channels, rhs.channels, sizeof(color_t) * 3);
   }
@@ -5,6 +5,7 @@ using std::ifstream;
 #include <sstream>
 using std::ostringstream;
 #include <algorithm>
+#include <charconv>
 #include <iterator>
 #include <iomanip>
 
@@ -35,76 +36,33 @@ constexpr std::string_view WHITESPACE = " \n\r\t\f\v";
 /// Types of char to be treated as comment both at the beginning of a line or in the middle of it.
 constexpr std::string_view COMMENT = ";";
 
-/// Lambda expression that transform the string to lowercase.
-auto TO_LOWERCASE = [](const std::string& s)->std::string {
-    std::string str{ s };
-    std::transform( str.begin(), str.end(), str.begin(), ::tolower );
-    return str;
-};
-
-/// Remove all quotation marks on a string.
-auto REMOVE_QUOTES = [](const std::string& s)->std::string {
-    std::string str;
-    std::copy_if(s.cbegin(),s.cend(),
-                 std::back_inserter(str),
-                 [](unsigned char c) { return c != '"'; });
-    return str;
-};
-
-/// Remove all square brackets from a string.
-auto REMOVE_SQUARE_BRACKETS= [](const std::string& s)->std::string {
-    std::string str;
-    std::copy_if(s.cbegin(),s.cend(),
-                 std::back_inserter(str),
-                 [](unsigned char c) { return (c!='[' and c!=']'); });
-    return str;
-};
-
-/// Trim all content after a comment characters (included) located in a string
-auto REMOVE_COMMENTS= [](const std::string &s)->std::string {
-    size_t end = s.find_first_of(COMMENT);
-    return (end == std::string::npos) ? s : s.substr(0, end);
-};
+/// Name of the section of the fields declared before any section.
+constexpr std::string_view ROOT_SECTION = "ROOT";
 
-/// Remove all leading white spaces from a string.
-auto LTRIM = [](const std::string &s)->std::string {
+/// Remove all leading/trailing white spaces from a view.
+auto TRIM_WS = [](std::string_view s)->std::string_view {
     size_t start = s.find_first_not_of(WHITESPACE);
-    return (start == std::string::npos) ? "" : s.substr(start);
+    if(start == std::string_view::npos) return {};
+    size_t end = s.find_last_not_of(WHITESPACE);
+    return s.substr(start, end - start + 1);
 };
 
-/// Remove all trailing white spaces from a string.
-auto RTRIM = [](const std::string &s)->std::string {
-    size_t end = s.find_last_not_of(WHITESPACE);
-    return (end == std::string::npos) ? "" : s.substr(0, end + 1);
+/// Trim all content after a comment characters (included) located in a view.
+auto REMOVE_COMMENTS = [](std::string_view s)->std::string_view {
+    return s.substr(0, s.find_first_of(COMMENT));
 };
 
-/// Remove all leading/trailing white spaces from a string.
-auto TRIM_WS = [](const std::string &s)->std::string {
-    return RTRIM(LTRIM(s));
+/// Remove, in place, all the characters in `chars` from the text a view points to; returns the shortened view.
+auto ERASE_IN_PLACE = [](std::string_view s, char* data, std::string_view chars)->std::string_view {
+    auto end = std::remove_if(data, data + s.size(), [&](char c){ return chars.find(c) != std::string_view::npos; });
+    return { data, size_t(end - data) };
 };
 
-/// Tokenize a string into componentes separated by a delimiter.
-/*!
- * Split a string into a list of components (tokens) which were separeted
- * by the `delimiter` in the original string.
- * \note White spaces are removed.
- *
- * @param input_str The input string.
- * @param delimiter The delimiter symbol.
- * @return A list of tokenized strings.
- */
-std::vector<std::string> split(const std::string & input_str, char delimiter=' '){
-    // Store the tokens.
-    std::vector<std::string> tokens;
-    // read tokens from a string buffer.
-    std::istringstream iss;
-    iss.str(input_str);
-    // This will hold a single token temporarily.
-    std::string token;
-    while (std::getline(iss >> std::ws, token, delimiter))
-        tokens.emplace_back(token);
-    return tokens;
-}
+/// Compare two views ignoring case.
+auto EQUALS_NOCASE = [](std::string_view a, std::string_view b)->bool {
+    return a.size() == b.size() and std::equal(a.begin(), a.end(), b.begin(),
+        [](unsigned char x, unsigned char y){ return ::tolower(x) == ::tolower(y); });
+};
 
 
 //===============================================//
@@ -112,56 +70,75 @@ std::vector<std::string> split(const std::string & input_str, char delimiter=' '
 //-----------------------------------------------//
 
 
+/*!
+ * The whole file is read into a single buffer, which is then edited in place
+ * (comments are cut, quotes and brackets removed, section names lowercased),
+ * so sections, fields and values are all views into it. Each section name is
+ * kept once, and the fields end up in a single table sorted by section and
+ * field name, which is binary searched by the access methods.
+ */
 TIP::TIP(const std::string_view& filename)
     : m_error_code{OK},
       m_section_line{0},
       m_field_line{0}
 {
-    std::fstream ifs(filename.data());
+    std::ifstream ifs(filename.data(), std::ios::binary);
     // Check if openning was successful.
     if(not ifs.is_open()){
         m_error_code = code_t::CANNOT_OPEN_FILE;
         return;
     }
-    // Let us parse each line from the input file.
-    std::string line;
+    m_buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    ifs.close();
+
+    // Interns a section name, returning its index.
+    auto intern = [this](std::string_view name)->uint32_t {
+        auto it = std::find(m_section_names.begin(), m_section_names.end(), name);
+        if(it != m_section_names.end()) return it - m_section_names.begin();
+        m_section_names.push_back(name);
+        return m_section_names.size() - 1;
+    };
+
+    // Let us parse each line from the buffer.
     size_t line_number{0};
-    std::string curr_section_name{"ROOT"}; // Default section name.
-    while(std::getline(ifs, line)){ // remove leading white spaces.
+    uint32_t curr_section = intern(ROOT_SECTION); // Default section name.
+    size_t pos{0};
+    while(pos < m_buffer.size()){
+        size_t eol = std::min(m_buffer.find('\n', pos), m_buffer.size());
+        char* data = m_buffer.data() + pos;
+        std::string_view line{data, eol - pos};
+        pos = eol + 1;
         // [1]: remove comments and surrounding spaces.
         auto s_line = TRIM_WS(REMOVE_COMMENTS(line));
         // [2]: Always increment line count (to support more precise error messages)
         line_number++;
         // [3]: Skip empty lines or comment lines.
         if(s_line.empty()){
-            ; // Get next line from file.
+            ; // Get next line from buffer.
         } else if(s_line[0]=='['){
             // [4]: Looking for a section indication.
             // Keep track of the line the section begins at.
             m_section_line = line_number;
             // Strip line and remove indicators of a section.
-            curr_section_name = TO_LOWERCASE(REMOVE_SQUARE_BRACKETS(s_line));
-            // Create a new (empty) Hash Map associated with this section.
-            m_sections[curr_section_name] = HashMap{};
+            auto name = ERASE_IN_PLACE(s_line, const_cast<char*>(s_line.data()), "[]");
+            std::transform(name.begin(), name.end(), const_cast<char*>(name.data()), ::tolower);
+            curr_section = intern(name);
         } else {
             // [5]: Parsing a field.
             m_field_line = line_number;
-            auto stripped_line = REMOVE_QUOTES(s_line);
-            auto tokens = split(stripped_line,'='); // Break up field and value.
-            if(tokens.empty() or tokens.size()>2) {
-                m_error_code = code_t::INVALID_FIELD; // Too little or too many information.
-            } else if(tokens.size()==1){ // We've just got the field, no value though.
-                m_error_code = code_t::INCOMPLETE_FIELD;
-            } else { // Got exactly 2 tokens.
+            auto stripped_line = ERASE_IN_PLACE(s_line, const_cast<char*>(s_line.data()), "\"");
+            auto equal = stripped_line.find('='); // Break up field and value.
+            if(equal == std::string_view::npos or TRIM_WS(stripped_line.substr(equal+1)).empty()){
+                m_error_code = code_t::INCOMPLETE_FIELD; // We've just got the field, no value though.
+            } else if(stripped_line.find('=', equal+1) != std::string_view::npos){
+                m_error_code = code_t::INVALID_FIELD; // Too many information.
+            } else {
                 // Let us check if the field name has only one word (i.e. no spaces between them).
-                auto tokens_parts = split(tokens[0],' ');
-                if(tokens_parts.size()!=1){
+                auto field = TRIM_WS(stripped_line.substr(0, equal));
+                if(field.empty() or field.find_first_of(WHITESPACE) != std::string_view::npos){
                     m_error_code = code_t::INVALID_FIELD_NAME;
                 } else { // Everything ok. Store it!
-                    // Retrieve hash map associated w/ the current section
-                    HashMap &m = m_sections[curr_section_name];
-                    // Remember to strip tokens off of any leading/trailing spaces.
-                    m[TRIM_WS(tokens[0])] = TRIM_WS(tokens[1]); // Store pair <field,value> in the map.
+                    m_entries.push_back({curr_section, field, TRIM_WS(stripped_line.substr(equal+1)), uint32_t(line_number)});
                 }
             }
         }
@@ -169,7 +146,29 @@ TIP::TIP(const std::string_view& filename)
         if(m_error_code!=code_t::OK)
             break; // Stop here.
     }
-    ifs.close();
+
+    // Sorts the sections, and the entries by section and field. Among repeated fields the last one wins.
+    vector<uint32_t> order(m_section_names.size()), rank(m_section_names.size());
+    for(uint32_t i{0}; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return m_section_names[a] < m_section_names[b]; });
+    vector<string_view> sorted_names;
+    for(uint32_t i{0}; i < order.size(); i++){
+        rank[order[i]] = i;
+        sorted_names.push_back(m_section_names[order[i]]);
+    }
+    m_section_names = std::move(sorted_names);
+    for(auto& entry : m_entries) entry.section = rank[entry.section];
+
+    auto by_key = [](const Entry& a, const Entry& b){
+        return a.section < b.section or (a.section == b.section and a.field < b.field);
+    };
+    std::stable_sort(m_entries.begin(), m_entries.end(), by_key);
+    vector<Entry> unique;
+    for(const auto& entry : m_entries){
+        if(not unique.empty() and not by_key(unique.back(), entry)) unique.back() = entry;
+        else unique.push_back(entry);
+    }
+    m_entries = std::move(unique);
 }
 
 std::string
@@ -190,24 +189,23 @@ TIP::parser_error_msg(void) const{
 }
 
 /// Returns a list of field names found in the database associated with a given section name.
-std::vector<std::string> TIP::get_fields_list(const std::string& section_) const{
+std::vector<std::string> TIP::get_fields_list(string_view section_) const{
     std::vector<std::string> fields;
     // Does this section exist?
-    if(m_sections.count(section_)!=0){
+    auto it = std::lower_bound(m_section_names.begin(), m_section_names.end(), section_);
+    if(it != m_section_names.end() and *it == section_){
         // Capture all fields of this particular section.
-        for(const auto&[field, value] : m_sections.at(section_))
-            fields.emplace_back(field);
+        uint32_t section = it - m_section_names.begin();
+        for(const auto& entry : m_entries)
+            if(entry.section == section) fields.emplace_back(entry.field);
     }
     return fields;
 }
 
 /// Returns a list of section names found in the database.
 std::vector<std::string> TIP::get_sections_list(void) const{
-    std::vector<std::string> sections;
     // Capture all the sections from this file.
-    for(const auto&[sec_name, hmap] : m_sections)
-        sections.emplace_back(sec_name);
-    return sections;
+    return std::vector<std::string>(m_section_names.begin(), m_section_names.end());
 }
 
 /*!
@@ -220,22 +218,35 @@ std::vector<std::string> TIP::get_sections_list(void) const{
  * @param section_ The section name.
  * @param field_ The field name inside the section.
  * @param fbv_ The fall back value.
- * @return The **string** value of the requested field, or the fall back value in case an error is detected.
+ * @return The **string** value of the requested field in lowercase, or the fall back value in case an error is detected.
  * @see retrieve_value()
  */
-std::string TIP::get_str(const string& section_, const string& field_, const string& fbv_) {
-    // Fall back value in case the retrieving failed.
-    auto value{fbv_};
+std::string TIP::get_str(string_view section_, string_view field_, string_view fbv_) {
     // Retrieve the field value as a plain string.
     auto str_val= retrieve_value(section_, field_);
     // Have we got a value?
-    if(str_val.has_value()){
-        // Try to convert string to the expected type.
-        value = str_val.value();
-    }
+    if(not str_val.has_value()) return std::string{fbv_};
+    std::string value{str_val.value()};
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
     return value;
 }
 
+/*!
+ * Retrive from the INI database a view of the value associated
+ * with the Field `field_`, defined in Section `section_`, exactly
+ * as written in the file (but with no quotes). The view is valid
+ * as long as this object.
+ *
+ * @param section_ The section name.
+ * @param field_ The field name inside the section.
+ * @param fbv_ The fall back value.
+ * @return The value of the requested field, or the fall back value in case an error is detected.
+ * @see retrieve_value()
+ */
+std::string_view TIP::get_view(string_view section_, string_view field_, string_view fbv_) {
+    return retrieve_value(section_, field_).value_or(fbv_);
+}
+
 /*!
  * Retrive from the INI database an **integer** value associated
  * with the Field `field_`, defined in Section `section_`.
@@ -249,7 +260,7 @@ std::string TIP::get_str(const string& section_, const string& field_, const str
  * @return The **int** value of the requested field, or the fall back value in case an error is detected.
  * @see retrieve_value()
  */
-int TIP::get_int (const string& section_, const string& field_, int fbv_) {
+int TIP::get_int (string_view section_, string_view field_, int fbv_) {
     // Fall back value in case the retrieving failed.
     auto value{fbv_};
     // Retrieve the field value as a plain string.
@@ -257,9 +268,10 @@ int TIP::get_int (const string& section_, const string& field_, int fbv_) {
     // Have we got a value?
     if(str_val.has_value()){
         // Try to convert to integer.
-        try { value = std::stoi(str_val.value()); }
+        auto converted = to_int(str_val.value());
+        if(converted.has_value()) value = converted.value();
         // Could not convert into a valid integer.
-        catch(...){ m_error_code = code_t::INVALID_INT_VALUE; }
+        else m_error_code = code_t::INVALID_INT_VALUE;
     }
     return value;
 }
@@ -277,7 +289,7 @@ int TIP::get_int (const string& section_, const string& field_, int fbv_) {
  * @return The **real** value of the requested field, or the fall back value in case an error is detected.
  * @see retrieve_value()
  */
-TIP::real_t TIP::get_real(const string& section_, const string& field_, real_t fbv_) {
+TIP::real_t TIP::get_real(string_view section_, string_view field_, real_t fbv_) {
     // Fall back value in case the retrieving failed.
     auto value{fbv_};
     // Retrieve the field value as a plain string.
@@ -285,9 +297,10 @@ TIP::real_t TIP::get_real(const string& section_, const string& field_, real_t f
     // Have we got a value?
     if(str_val.has_value()){
         // Try to convert the string into a real value.
-        try { value = std::stof(str_val.value()); }
-        // Could not convert into a valid integer.
-        catch(...){ m_error_code = code_t::INVALID_REAL_VALUE; }
+        auto converted = to_real(str_val.value());
+        if(converted.has_value()) value = converted.value();
+        // Could not convert into a valid real.
+        else m_error_code = code_t::INVALID_REAL_VALUE;
     }
     return value;
 }
@@ -305,7 +318,7 @@ TIP::real_t TIP::get_real(const string& section_, const string& field_, real_t f
  * @return The **bool** value of the requested field, or the fall back value in case an error is detected.
  * @see retrieve_value()
  */
-bool TIP::get_bool(const string& section_, const string& field_, bool fbv_) {
+bool TIP::get_bool(string_view section_, string_view field_, bool fbv_) {
     // Fall back value in case the retrieving failed.
     auto value{fbv_};
     // Retrieve the field value as a plain string.
@@ -313,17 +326,38 @@ bool TIP::get_bool(const string& section_, const string& field_, bool fbv_) {
     // Have we got a value?
     if(str_val.has_value()){
         // Try to convert string to the expected type.
-        if(str_val.value()=="true"){
-            value = true;
-        } else if(str_val.value()=="false"){
-            value = false;
-        } else { // Could not convert into a valid bool.
-            m_error_code = code_t::INVALID_BOOL_VALUE;
-        }
+        auto converted = to_bool(str_val.value());
+        if(converted.has_value()) value = converted.value();
+        // Could not convert into a valid bool.
+        else m_error_code = code_t::INVALID_BOOL_VALUE;
     }
     return value;
 }
 
+/*!
+ * Reads each of the given fields into its variable, with the conversion
+ * of the corresponding get method. Variables of missing fields keep their
+ * current value, which works as the fall back value.
+ *
+ * @param bindings The section/field pairs and the variables that receive them.
+ * @return False if any of the values found could not be converted.
+ */
+bool TIP::bind(std::initializer_list<Binding> bindings){
+    bool ok{true};
+    for(const auto& b : bindings){
+        std::visit([&](auto* target){
+            using T = std::remove_pointer_t<decltype(target)>;
+            if constexpr (std::is_same_v<T, int>) *target = get_int(b.section, b.field, *target);
+            else if constexpr (std::is_same_v<T, bool>) *target = get_bool(b.section, b.field, *target);
+            else if constexpr (std::is_same_v<T, real_t>) *target = get_real(b.section, b.field, *target);
+            else *target = get_str(b.section, b.field, *target);
+        }, b.target);
+        if(m_error_code==INVALID_INT_VALUE or m_error_code==INVALID_REAL_VALUE or m_error_code==INVALID_BOOL_VALUE)
+            ok = false;
+    }
+    return ok;
+}
+
 /*!
  * Retrive from the INI database a string value associated
  * with the Field `field_`, defined in Section `section_`.
@@ -339,49 +373,94 @@ bool TIP::get_bool(const string& section_, const string& field_, bool fbv_) {
  *
  * @param section_ The section name.
  * @param field_ The field name inside the section.
- * @return The string value assigned to the field inside the section, or an empty value.
+ * @return A view of the value assigned to the field inside the section, or an empty value.
  */
-std::optional<std::string> TIP::retrieve_value(const string& section_, const string& field_){
+std::optional<std::string_view> TIP::retrieve_value(string_view section_, string_view field_){
     // Reset the current error code.
     m_error_code = code_t::OK;
     // Does this section exist?
-    if(m_sections.count(section_)==0){
+    auto sec = std::lower_bound(m_section_names.begin(), m_section_names.end(), section_);
+    if(sec == m_section_names.end() or *sec != section_){
         m_error_code = code_t::SECTION_NOT_FOUND;
     } else { // Section found, proceed...
-        // Retrieve HashMap associated with this section name.
-        const HashMap &hm = m_sections[section_];
         // Do we have the field name stored?
-        if(hm.count(field_)==0){
+        Entry key{uint32_t(sec - m_section_names.begin()), field_, {}, 0};
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), key, [](const Entry& a, const Entry& b){
+            return a.section < b.section or (a.section == b.section and a.field < b.field);
+        });
+        if(it == m_entries.end() or it->section != key.section or it->field != field_){
             m_error_code = code_t::FIELD_NOT_FOUND;
         } else { // Ok, field value found.
-            return TO_LOWERCASE(hm.at(field_));
+            return it->value;
         }
     }
     return {};
 }
 
+/// Like std::stoi, a leading '+' and trailing characters are accepted.
+std::optional<int> TIP::to_int(string_view str){
+    if(not str.empty() and str[0] == '+') str.remove_prefix(1);
+    int converted;
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), converted);
+    if(ec != std::errc{}) return {};
+    return converted;
+}
+
+/// Like std::stof, a leading '+' and trailing characters are accepted.
+std::optional<TIP::real_t> TIP::to_real(string_view str){
+    if(not str.empty() and str[0] == '+') str.remove_prefix(1);
+    real_t converted;
+    auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), converted);
+    if(ec != std::errc{}) return {};
+    return converted;
+}
+
+/// Only "true" and "false" are valid, in any case.
+std::optional<bool> TIP::to_bool(string_view str){
+    if(EQUALS_NOCASE(str, "true")) return true;
+    if(EQUALS_NOCASE(str, "false")) return false;
+    return {};
+}
+
+std::string TIP::to_lower(string_view str){
+    std::string lower{str};
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
+std::string TIP::range_text(double min, double max){
+    std::ostringstream oss;
+    if(max >= INT_MAX) oss << "must be at least " << min;
+    else if(min <= INT_MIN) oss << "must be at most " << max;
+    else oss << "must be between " << min << " and " << max;
+    return oss.str();
+}
+
+void TIP::schema_error(size_t line, string_view section, string_view field, string_view what){
+    std::ostringstream oss;
+    oss << "[" << section << "] " << field << ": " << what;
+    if(line > 0) oss << ", at line " << line << ".";
+    m_schema_errors.push_back(oss.str());
+}
+
 std::string TIP::pretty_print(void) const{
     std::ostringstream oss;
     // Get the section list so we can traverse their fields.
-    auto sections = get_sections_list();
-    for(const auto& sec_name : sections){
+    for(uint32_t section{0}; section < m_section_names.size(); section++){
         // Lets determine the max field length. We need this to align all fields.
         size_t max_field_len{0};
-        auto fields = get_fields_list(sec_name);
-        std::for_each(fields.cbegin(),fields.cend(),
-                [&](const string& s)
-                { max_field_len = std::max(max_field_len,s.length()); });
+        for(const auto& entry : m_entries)
+            if(entry.section == section) max_field_len = std::max(max_field_len, entry.field.length());
         // Print the section name.
-        oss << "[" << sec_name << "]\n";
-        // Retrieve HashMap associated with this section name.
-        const HashMap &hm = m_sections.at(sec_name);
+        oss << "[" << m_section_names[section] << "]\n";
         // Now print the fields, all right-algined;
         // the equal sign is placed at the same column in every line.
-        for(const auto& field_name : fields)
-            oss << "    "
-                << std::setw(max_field_len) << field_name
-                << " = "
-                << std::quoted(hm.at(field_name)) << "\n";
+        for(const auto& entry : m_entries)
+            if(entry.section == section)
+                oss << "    "
+                    << std::setw(max_field_len) << entry.field
+                    << " = "
+                    << std::quoted(std::string{entry.value}) << "\n";
         oss << '\n';
     }
     return oss.str();
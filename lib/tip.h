@@ -7,10 +7,13 @@ using std::string;
 using std::string_view;
 #include <vector>
 using std::vector;
-#include <map>
-using std::map;
 #include <optional>
 using std::optional;
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <variant>
 
 /*
  * TODO:
@@ -39,19 +42,102 @@ class TIP{
             INVALID_REAL_VALUE,//!< Invalid real value.
             INVALID_BOOL_VALUE,//!< Invalid boolean value.
         };
+        /// A field to be read by bind(), and the variable that receives its value.
+        struct Binding {
+            string_view section; //!< The section name.
+            string_view field;   //!< The field name inside the section.
+            std::variant<int*, bool*, real_t*, string*> target; //!< Where the value goes.
+        };
+        /// Describes a field of the configuration struct `T`, for load().
+        /*!
+         * Each constructor takes a member pointer of one type and a fall back
+         * value of that same type, so a schema with mismatched types does not
+         * compile. Ranges apply to numbers; string fields may list their valid
+         * values as `"a|b|c"`, which are then matched ignoring case.
+         */
+        template <typename T>
+        struct Field {
+            string_view section;  //!< The section name ("ROOT" for fields outside any section).
+            string_view field;    //!< The field name inside the section.
+            std::variant<int T::*, bool T::*, real_t T::*, string T::*> member; //!< Where the value goes.
+            std::variant<int, bool, real_t, string_view> fbv; //!< Value used when the field is missing.
+            double min{0}, max{0};//!< Valid range of numbers (inclusive).
+            string_view choices;  //!< Valid values of strings, separated by '|' (empty means any).
+
+            constexpr Field(string_view s, string_view f, int T::* m, int fbv_, double min_ = INT_MIN, double max_ = INT_MAX)
+                : section{s}, field{f}, member{m}, fbv{fbv_}, min{min_}, max{max_} {}
+            constexpr Field(string_view s, string_view f, bool T::* m, bool fbv_)
+                : section{s}, field{f}, member{m}, fbv{fbv_} {}
+            constexpr Field(string_view s, string_view f, real_t T::* m, real_t fbv_, double min_, double max_)
+                : section{s}, field{f}, member{m}, fbv{fbv_}, min{min_}, max{max_} {}
+            constexpr Field(string_view s, string_view f, string T::* m, string_view fbv_, string_view choices_ = "")
+                : section{s}, field{f}, member{m}, fbv{fbv_}, choices{choices_} {}
+
+            /// Returns true if `value` is one of the choices (or if there are none).
+            constexpr bool is_choice(string_view value) const {
+                if(choices.empty()) return true;
+                for(size_t start{0}; start <= choices.size();){
+                    size_t end = choices.find('|', start);
+                    if(end == string_view::npos) end = choices.size();
+                    if(choices.substr(start, end - start) == value) return true;
+                    start = end + 1;
+                }
+                return false;
+            }
+            /// Returns true if the fall back value is valid for this field.
+            constexpr bool valid_fbv(void) const {
+                switch(fbv.index()){
+                    case 0: return std::get<0>(fbv) >= min and std::get<0>(fbv) <= max;
+                    case 2: return std::get<2>(fbv) >= min and std::get<2>(fbv) <= max;
+                    case 3: return is_choice(std::get<3>(fbv));
+                    default: return true;
+                }
+            }
+        };
+        /// Returns true if a schema has no repeated fields and all its fall back values are valid.
+        /*! Meant for a `static_assert`, so a broken schema is caught at compile time. */
+        template <typename T, size_t N>
+        static constexpr bool valid_schema(const std::array<Field<T>, N>& schema){
+            for(size_t i{0}; i < N; i++){
+                if(not schema[i].valid_fbv()) return false;
+                for(size_t j{i+1}; j < N; j++)
+                    if(schema[i].section == schema[j].section and schema[i].field == schema[j].field) return false;
+            }
+            return true;
+        }
 
     private:
-        /// Basic map of fields and values.
-        typedef map<string,string> HashMap;
+        /// A field-value pair. Both views point into `m_buffer`.
+        struct Entry {
+            uint32_t section;  //!< Index of the section in `m_section_names`.
+            string_view field; //!< The field name.
+            string_view value; //!< The field value, as written in the file (no quotes).
+            uint32_t line;     //!< Line of the file the field is declared at.
+        };
         //== Data members
-        map<string, HashMap> m_sections; //!< List of all section entries.
-        code_t m_error_code=OK;          //!< Current error code.
-        size_t m_section_line=0;         //!< Keeps track of the current section line number
-        size_t m_field_line=0;           //!< Keeps track of the current field line number
+        string m_buffer;                   //!< The whole file; every view below points into it.
+        vector<string_view> m_section_names; //!< Each section name once, sorted.
+        vector<Entry> m_entries;           //!< All fields, sorted by section and field name.
+        code_t m_error_code=OK;            //!< Current error code.
+        size_t m_section_line=0;           //!< Keeps track of the current section line number
+        size_t m_field_line=0;             //!< Keeps track of the current field line number
+        vector<string> m_schema_errors;    //!< Errors found by the last load().
 
     private:
-        /// Aux method that retrieves a string given a section/field pair of information.
-        std::optional<string> retrieve_value(c_str_ref section, c_str_ref field);
+        /// Aux method that retrieves the value of a section/field pair, without allocating.
+        std::optional<string_view> retrieve_value(string_view section, string_view field);
+        /// Converts a value to an integer, like get_int() does.
+        static std::optional<int> to_int(string_view value);
+        /// Converts a value to a real, like get_real() does.
+        static std::optional<real_t> to_real(string_view value);
+        /// Converts a value to a bool, like get_bool() does.
+        static std::optional<bool> to_bool(string_view value);
+        /// Returns a lowercase copy of a value.
+        static string to_lower(string_view value);
+        /// Describes a valid range, for errors found by load().
+        static string range_text(double min, double max);
+        /// Records an error found by load(), at the given line (zero if none).
+        void schema_error(size_t line, string_view section, string_view field, string_view what);
 
     public:
         /// Ctro. Requires the INI filename as input.
@@ -72,21 +158,90 @@ class TIP{
         string parser_error_msg(void) const;
 
         /// Retrieve the list of all fields for a given section name.
-        vector<string> get_fields_list(c_str_ref section_name) const;
+        vector<string> get_fields_list(string_view section_name) const;
         /// Retrieve the list of all sections found in this file.
         vector<string> get_sections_list(void) const;
         /// Returns a string with a pretty printed version of the database content.
         string pretty_print(void) const;
 
         //== Field access methods
-        /// Retrieves a string from the database.
-        string get_str  (c_str_ref section, c_str_ref field, c_str_ref fbv="empty");
+        /// Retrieves a (lowercase) string from the database.
+        string get_str  (string_view section, string_view field, string_view fbv="empty");
+        /// Retrieves a string from the database, as written in the file, without copying it.
+        string_view get_view(string_view section, string_view field, string_view fbv="");
         /// Retrieves an integer value from the database.
-        int    get_int  (c_str_ref section, c_str_ref field, int       fbv=0);
+        int    get_int  (string_view section, string_view field, int       fbv=0);
         /// Retrieves a bool value from the database.
-        bool   get_bool (c_str_ref section, c_str_ref field, bool      fbv=false);
+        bool   get_bool (string_view section, string_view field, bool      fbv=false);
         /// Retrieves a real value from the database.
-        real_t get_real (c_str_ref section, c_str_ref field, real_t    fbv=0.f);
+        real_t get_real (string_view section, string_view field, real_t    fbv=0.f);
+        /// Reads many fields at once; each variable keeps its value if its field is missing.
+        bool   bind     (std::initializer_list<Binding> bindings);
+
+        //== Schema methods
+        /// Fills `config` from the file, as described by `schema`, in a single pass over the fields.
+        template <typename T, size_t N>
+        bool load(T& config, const std::array<Field<T>, N>& schema);
+        /// Returns the errors found by the last load(): unknown fields, invalid values and values out of range.
+        const vector<string>& schema_errors(void) const { return m_schema_errors; }
 };
 
+/*!
+ * First every member receives its fall back value; then each field found in
+ * the file is matched against the schema, converted and checked. Fields not
+ * in the schema (usually misspelled ones) are errors too, so nothing falls
+ * back silently.
+ *
+ * @param config The struct that receives the values.
+ * @param schema The fields of the struct.
+ * @return True if no errors were found; otherwise see schema_errors().
+ */
+template <typename T, size_t N>
+bool TIP::load(T& config, const std::array<Field<T>, N>& schema){
+    m_schema_errors.clear();
+    for(const auto& f : schema){
+        std::visit([&](auto member){
+            using V = std::remove_reference_t<decltype(config.*member)>;
+            if constexpr (std::is_same_v<V, string>) config.*member = string{std::get<string_view>(f.fbv)};
+            else config.*member = std::get<V>(f.fbv);
+        }, f.member);
+    }
+
+    for(const auto& entry : m_entries){
+        auto section = m_section_names[entry.section];
+        const Field<T>* f{nullptr};
+        for(const auto& candidate : schema)
+            if(candidate.section == section and candidate.field == entry.field) f = &candidate;
+        if(f == nullptr){
+            schema_error(entry.line, section, entry.field, "unknown field");
+            continue;
+        }
+        std::visit([&](auto member){
+            using V = std::remove_reference_t<decltype(config.*member)>;
+            if constexpr (std::is_same_v<V, string>){
+                // Strings with choices are matched ignoring case; free ones (paths) are kept as written.
+                if(f->choices.empty()) config.*member = string{entry.value};
+                else if(f->is_choice(to_lower(entry.value))) config.*member = to_lower(entry.value);
+                else schema_error(entry.line, section, entry.field, "must be one of " + string{f->choices});
+            } else {
+                std::optional<V> value;
+                if constexpr (std::is_same_v<V, int>) value = to_int(entry.value);
+                else if constexpr (std::is_same_v<V, bool>) value = to_bool(entry.value);
+                else value = to_real(entry.value);
+
+                if(not value.has_value()){
+                    schema_error(entry.line, section, entry.field, "invalid value");
+                } else if constexpr (not std::is_same_v<V, bool>){
+                    if(*value < f->min or *value > f->max)
+                        schema_error(entry.line, section, entry.field, range_text(f->min, f->max));
+                    else config.*member = *value;
+                } else {
+                    config.*member = *value;
+                }
+            }
+        }, f->member);
+    }
+    return m_schema_errors.empty();
+}
+
 #endif /* end of include guard: TIP_H */
@@ -0,0 +1,123 @@
+//! Scoped trace zones, dumped as Chrome trace events.
+/*!
+ * @file trace.h
+ *
+ * @details Put `TRACE_ZONE("name");` at the top of a block to record how
+ * long it takes. Zones are only compiled in when `GLIFE_TRACE` is defined
+ * (`-DGLIFE_TRACE`); otherwise the macro expands to nothing.
+ *
+ * Each thread records its zones in its own buffer, so recording takes no
+ * locks. At exit, every buffer is written to `GLIFE_TRACE_FILE` (by default
+ * "trace.json") in the Chrome trace event format, which can be opened on
+ * chrome://tracing or https://ui.perfetto.dev.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef GLIFE_TRACE
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifndef GLIFE_TRACE_FILE
+#define GLIFE_TRACE_FILE "trace.json"
+#endif
+
+namespace life {
+namespace trace {
+
+/// Nanoseconds of the steady clock (since boot, usually).
+inline int64_t now(void){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// A finished zone.
+struct Event {
+    const char* name;  //!< Name of the zone (a string literal).
+    int64_t start;     //!< When the zone began, in nanoseconds.
+    int64_t duration;  //!< How long the zone took, in nanoseconds.
+};
+
+/// The zones recorded by one thread.
+struct ThreadBuffer {
+    uint32_t tid;               //!< Sequential id of the thread.
+    std::vector<Event> events;  //!< Events, in the order they finished.
+};
+
+/// Owns the buffers of every thread, and writes them out at exit.
+class Registry {
+   public:
+    ~Registry(){
+        std::ofstream out{GLIFE_TRACE_FILE};
+        // Microseconds since the registry was created, with the nanoseconds kept as decimals.
+        out << std::fixed << std::setprecision(3);
+        out << "{\"traceEvents\":[\n";
+        bool first{true};
+        for(const auto& buffer : m_buffers){
+            for(const auto& event : buffer->events){
+                out << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << buffer->tid << ",\"ts\":" << (event.start - m_epoch)/1000.0 << ",\"dur\":" << event.duration/1000.0 << "}";
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    /// Creates the buffer of a new thread. Only called once per thread.
+    ThreadBuffer* add_thread(void){
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_buffers.push_back(std::make_unique<ThreadBuffer>());
+        m_buffers.back()->tid = m_buffers.size();
+        m_buffers.back()->events.reserve(1 << 16);
+        return m_buffers.back().get();
+    }
+
+   private:
+    int64_t m_epoch{now()};                             //!< When the registry was created; times are written from it.
+    std::mutex m_mutex;                                 //!< Guards the list of buffers.
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers; //!< One buffer per thread; kept after the thread ends.
+};
+
+/// The registry of the program.
+inline Registry registry;
+
+/// Returns the buffer of the calling thread.
+inline ThreadBuffer& thread_buffer(void){
+    thread_local ThreadBuffer* buffer = registry.add_thread();
+    return *buffer;
+}
+
+/// Records the time between its construction and destruction.
+class Zone {
+   public:
+    explicit Zone(const char* name) : m_name{name}, m_start{now()} {}
+    ~Zone(){ thread_buffer().events.push_back({m_name, m_start, now() - m_start}); }
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+   private:
+    const char* m_name; //!< Name of the zone.
+    int64_t m_start;    //!< When the zone began.
+};
+
+}  // namespace trace
+}  // namespace life
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+/// Records the time until the end of the enclosing block as a zone called `name`.
+#define TRACE_ZONE(name) ::life::trace::Zone TRACE_CONCAT(trace_zone_, __LINE__){name}
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+
+#endif  // GLIFE_TRACE
+
+#endif  // TRACE_H
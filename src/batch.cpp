@@ -0,0 +1,166 @@
+/**
+ * Batch runner implementation.
+ *
+ */
+
+#include "batch.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <glob.h>
+#include <utility>
+
+namespace life {
+
+/// Returns the verdict as a single word, for the summaries.
+static const char* verdict_name(Verdict verdict){
+    switch(verdict){
+        case Verdict::EXTINCT: return "extinct";
+        case Verdict::STABLE: return "stable";
+        case Verdict::ESCAPING: return "escaping";
+        default: return "max_gen";
+    }
+}
+
+/// Returns `text` as a JSON string, quoted, with quotes, backslashes and control characters escaped.
+static std::string json_string(const std::string& text){
+    std::string out{"\""};
+    for(char c : text){
+        switch(c){
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(c) < 0x20){
+                    char code[7];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                }
+                else out += c;
+        }
+    }
+    return out + '"';
+}
+
+/// Returns `text` as a CSV field: quoted, with its quotes doubled, if it has a comma, quote or line break.
+static std::string csv_field(const std::string& text){
+    if(text.find_first_of(",\"\r\n") == std::string::npos) return text;
+    std::string out{"\""};
+    for(char c : text){
+        if(c == '"') out += '"';
+        out += c;
+    }
+    return out + '"';
+}
+
+std::vector<std::string> expand_inputs(const std::string& spec){
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+
+    std::error_code ec;
+    if(fs::is_directory(spec, ec)){
+        for(const auto& entry : fs::directory_iterator(spec, ec)){
+            auto extension = entry.path().extension().string();
+            if(entry.is_regular_file() and (extension == ".dat" or extension == ".rle")){
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+    else{
+        glob_t matches;
+        if(glob(spec.c_str(), 0, nullptr, &matches) == 0){
+            for(size_t i{0u}; i < matches.gl_pathc; i++){
+                files.emplace_back(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<BatchEntry> run_batch(const std::vector<std::string>& files, const SimOptions& options, size_t n_threads){
+    std::vector<BatchEntry> entries(files.size());
+    ResultCache cache{options.cache.path};
+    {
+        ThreadPool pool{n_threads};
+        // Each task only touches its own entry, so there is nothing to synchronise.
+        for(size_t i{0u}; i < files.size(); i++){
+            pool.submit([&entry = entries[i], &file = files[i], &options, &cache]{
+                auto start = std::chrono::steady_clock::now();
+                entry.file = file;
+                Pattern pattern;
+                entry.loaded = load_pattern(file, pattern);
+                if(entry.loaded){
+                    LifeCfg table(std::move(pattern.cells), pattern.rows, pattern.cols);
+                    CacheKey key;
+                    size_t population{0};
+                    if(options.cache.enabled){
+                        key = cache_key(table, options);
+                        entry.cached = cache.find(key, entry.result, population);
+                    }
+                    if(not entry.cached){
+                        entry.result = simulate(table, options, [&entry](LifeCfg& t, unsigned long){
+                            entry.population.push_back(t.population());
+                        });
+                        // The visitor sees each generation before it is stepped, so not the last one.
+                        entry.population.push_back(table.population());
+                        if(options.cache.enabled) cache.insert(key, entry.result, table.population());
+                    }
+                }
+                entry.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            });
+        }
+    } // The pool waits for all tasks here.
+    return entries;
+}
+
+bool write_summary(const std::string& file_name, const std::vector<BatchEntry>& entries){
+    std::ofstream ofs(file_name);
+    if(not ofs.is_open()) return false;
+
+    bool json = file_name.length() >= 5 and file_name.substr(file_name.length()-5) == ".json";
+    if(json){
+        ofs << "[\n";
+        for(size_t i{0u}; i < entries.size(); i++){
+            const auto& e = entries[i];
+            ofs << "  {\"file\": " << json_string(e.file) << ", "
+                << "\"verdict\": \"" << (e.loaded ? verdict_name(e.result.verdict) : "error") << "\", "
+                << "\"final_generation\": " << e.result.generation << ", "
+                << "\"period\": " << e.result.period() << ", "
+                << "\"displacement\": [" << e.result.dx << ", " << e.result.dy << "], "
+                << "\"wall_seconds\": " << e.seconds << ", "
+                << "\"cached\": " << (e.cached ? "true" : "false") << ", "
+                << "\"population\": [";
+            for(size_t g{0u}; g < e.population.size(); g++){
+                ofs << (g ? ", " : "") << e.population[g];
+            }
+            ofs << "]}" << (i+1 < entries.size() ? "," : "") << "\n";
+        }
+        ofs << "]\n";
+    }
+    else{
+        // The population curve is a single field, with the generations separated by spaces.
+        ofs << "file,verdict,final_generation,period,dx,dy,wall_seconds,cached,population\n";
+        for(const auto& e : entries){
+            ofs << csv_field(e.file) << ','
+                << (e.loaded ? verdict_name(e.result.verdict) : "error") << ','
+                << e.result.generation << ','
+                << e.result.period() << ','
+                << e.result.dx << ',' << e.result.dy << ','
+                << e.seconds << ','
+                << e.cached << ',';
+            for(size_t g{0u}; g < e.population.size(); g++){
+                ofs << (g ? " " : "") << e.population[g];
+            }
+            ofs << '\n';
+        }
+    }
+    return true;
+}
+
+}  // namespace life
@@ -0,0 +1,42 @@
+//! Runs many initial configurations concurrently.
+/*!
+ * @file batch.h
+ *
+ * @details Each input file is simulated as an independent task on a thread
+ * pool, with its own LifeCfg and SimDatabase, and the results are gathered
+ * into a CSV or JSON summary. With the result cache enabled, files whose
+ * result is cached are not simulated at all.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <string>
+#include <vector>
+
+#include "simulation.h"
+
+namespace life {
+
+/// Result of a single simulation of a batch.
+struct BatchEntry {
+    std::string file;              //!< The input file.
+    bool loaded{false};            //!< False if the file could not be read.
+    SimResult result;              //!< How the simulation ended.
+    std::vector<size_t> population;//!< Population of generations 1 to result.generation (empty if cached).
+    bool cached{false};            //!< Whether the result came from the result cache.
+    double seconds{0};             //!< Wall time of the task, loading included.
+};
+
+/// Expands a directory (all its .dat and .rle files) or a glob pattern into a sorted list of files.
+std::vector<std::string> expand_inputs(const std::string& spec);
+
+/// Simulates each file on a pool of `n_threads` threads (zero means one per hardware thread).
+std::vector<BatchEntry> run_batch(const std::vector<std::string>& files, const SimOptions& options, size_t n_threads);
+
+/// Writes the summary of a batch as JSON if `file_name` ends with .json, or as CSV otherwise.
+bool write_summary(const std::string& file_name, const std::vector<BatchEntry>& entries);
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,166 @@
+/**
+ * Benchmark implementation.
+ *
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <sys/stat.h>
+
+#include "image.h"
+#include "scanline.h"
+
+namespace life {
+
+/// Size of a file in bytes, or zero if it doesn't exist.
+static size_t file_size(const std::string& file){
+    struct stat info;
+    return stat(file.c_str(), &info) == 0 ? info.st_size : 0;
+}
+
+/// Minimum time each engine is run on a pattern; short runs are repeated from the first generation until it is reached.
+constexpr double MIN_ENGINE_SECONDS = 0.2;
+
+/*!
+ * Every engine steps the same generations of each pattern, from the first,
+ * as many times as needed to take MIN_ENGINE_SECONDS; the cells they end
+ * with are compared, so a faster engine can't be a wrong one. Ratios are
+ * against the bit-sliced engine.
+ */
+void benchmark_engines(const std::vector<std::string>& files, const BenchmarkSettings& settings, std::ostream& os){
+    using Step = void (LifeCfg::*)(void);
+    // Returns the generations per second of `step` on `pattern`, and the cells it ends with.
+    auto measure = [&](const Pattern& pattern, Step step, std::vector<Cell>& cells){
+        unsigned long generations{0};
+        double seconds{0};
+        do{
+            LifeCfg table(pattern.cells, pattern.rows, pattern.cols);
+            auto start = std::chrono::steady_clock::now();
+            for(unsigned long gen{1u}; gen < settings.generations; gen++) (table.*step)();
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            generations += settings.generations - 1;
+            cells = table.get_alive_cells();
+        } while(seconds < MIN_ENGINE_SECONDS);
+        return generations/seconds;
+    };
+
+    os << "Engines: " << settings.generations << " generations of each pattern\n"
+       << "  " << std::left << std::setw(28) << "pattern" << std::right << std::setw(10) << "size"
+       << std::setw(16) << "bit-sliced" << std::setw(25) << "fixed size" << std::setw(25) << "4x4 table" << "\n";
+    for(const auto& file : files){
+        Pattern pattern;
+        if(not load_pattern(file, pattern)){
+            os << "  " << file << ": cannot be read\n";
+            continue;
+        }
+        std::vector<Cell> sliced_cells, cells;
+        bool same{true};
+        auto same_cells = [&]{
+            return cells.size() == sliced_cells.size()
+                   and std::equal(cells.begin(), cells.end(), sliced_cells.begin(), [](const Cell& a, const Cell& b){
+                       return a.row == b.row and a.col == b.col;
+                   });
+        };
+        // Prints generations per second, and the ratio to the bit-sliced engine.
+        auto column = [&](double speed, double sliced){
+            os << std::setprecision(0) << std::setw(12) << speed << " g/s"
+               << " (" << std::setprecision(2) << std::setw(4) << speed/sliced << "x)";
+        };
+
+        double sliced = measure(pattern, &LifeCfg::step_sliced, sliced_cells);
+        os << "  " << std::left << std::setw(28) << file << std::right
+           << std::setw(10) << std::to_string(pattern.rows) + "x" + std::to_string(pattern.cols)
+           << std::fixed << std::setprecision(0) << std::setw(12) << sliced << " g/s";
+        if(find_fixed_step(pattern.rows, pattern.cols) != nullptr){
+            column(measure(pattern, &LifeCfg::step, cells), sliced);
+            same = same and same_cells();
+        }
+        else{
+            os << std::setw(25) << "-";
+        }
+        column(measure(pattern, &LifeCfg::step_lut, cells), sliced);
+        same = same and same_cells();
+        os << (same ? "" : "  MISMATCH") << "\n";
+    }
+}
+
+/*!
+ * Each encoder gets the same generations, drawn the same way; only the
+ * encoding and writing is timed (the drawing is timed apart). The files
+ * are removed once measured.
+ */
+void benchmark_images(const Pattern& pattern, const BenchmarkSettings& settings, std::ostream& os){
+    auto dir = settings.path.empty() or settings.path.back() == '/' ? settings.path : settings.path + "/";
+    auto name = [&](unsigned long gen, const char* ext){ return "bench " + std::to_string(gen) + ext; };
+
+    struct Result {
+        std::string encoder;
+        double seconds{0};
+        size_t bytes{0};
+    };
+    std::vector<Result> results;
+    double draw_seconds{0};
+    size_t pixels{0};
+
+    // Runs the generations through `save`, which writes generation `gen` of `table`.
+    auto measure = [&](const std::string& encoder, const char* ext,
+                       const std::function<void(LifeCfg&, unsigned long)>& save, const std::function<void()>& finish){
+        LifeCfg table(pattern.cells, pattern.rows, pattern.cols);
+        Result result{encoder};
+        draw_seconds = 0;
+        for(unsigned long gen{1u}; gen <= settings.generations; gen++){
+            auto start = std::chrono::steady_clock::now();
+            table.set_life_canvas(settings.block_size, settings.bkg, settings.alive, settings.view);
+            auto drawn = std::chrono::steady_clock::now();
+            save(table, gen);
+            result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - drawn).count();
+            draw_seconds += std::chrono::duration<double>(drawn - start).count();
+            table.step();
+        }
+        auto start = std::chrono::steady_clock::now();
+        if(finish) finish();
+        result.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pixels = table.canvas().width()*table.canvas().height();
+        for(unsigned long gen{1u}; gen <= settings.generations; gen++){
+            result.bytes += file_size(dir + name(gen, ext));
+            std::remove((dir + name(gen, ext)).c_str());
+        }
+        results.push_back(result);
+    };
+
+    measure("P3 PPM", ".ppm", [&](LifeCfg& table, unsigned long gen){ table.save_img(dir, name(gen, "")); }, {});
+    measure("PNG, 1 thread", ".png", [&](LifeCfg& table, unsigned long gen){
+        table.save_png(dir, name(gen, ""), settings.png_level);
+    }, {});
+    ImageWriter writer{settings.threads, settings.png_level};
+    measure("PNG, thread pool", ".png", [&](LifeCfg& table, unsigned long gen){
+        writer.submit(table.canvas(), dir + name(gen, ".png"));
+    }, [&]{ writer.wait(); });
+    // Streamed images are made from the cells as they are written, so their time includes the drawing.
+    measure("P6 PPM, streamed", ".ppm", [&](LifeCfg& table, unsigned long gen){
+        TableScanlines source{table, settings.block_size, settings.bkg, settings.alive, settings.view};
+        stream_ppm(dir + name(gen, ".ppm"), source);
+    }, {});
+    measure("PNG, streamed", ".png", [&](LifeCfg& table, unsigned long gen){
+        TableScanlines source{table, settings.block_size, settings.bkg, settings.alive, settings.view};
+        stream_png(dir + name(gen, ".png"), source, settings.png_level);
+    }, {});
+
+    os << "Images: " << settings.generations << " generations of " << pattern.rows << "x" << pattern.cols
+       << " cells, " << pixels << " pixels each, png_level " << settings.png_level << "\n"
+       << std::fixed << std::setprecision(1)
+       << "  drawing: " << settings.generations/draw_seconds << " frames/s\n";
+    for(const auto& result : results){
+        os << "  " << std::left << std::setw(18) << result.encoder + ":" << std::right
+           << std::setw(9) << settings.generations/result.seconds << " frames/s, "
+           << std::setw(9) << pixels*settings.generations/result.seconds/1e6 << " Mpixels/s, "
+           << std::setw(9) << result.bytes/double(settings.generations)/1024 << " KB/frame\n";
+    }
+}
+
+}  // namespace life
@@ -0,0 +1,41 @@
+//! Throughput measurements of the program's hot paths.
+/*!
+ * @file benchmark.h
+ *
+ * @details The benchmark run mode: the same generations of a pattern are
+ * put through each alternative implementation of a hot path, and the
+ * throughput of each one is reported, so they can be compared on the
+ * machine at hand.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "life.h"
+
+namespace life {
+
+/// Settings of a benchmark run.
+struct BenchmarkSettings {
+    unsigned long generations{100}; //!< Generations of the pattern used.
+    short block_size{10};           //!< Block size of the images.
+    Color bkg{GREEN}, alive{RED};   //!< Colors of the images.
+    std::string path{"."};          //!< Where the images are written (and removed afterwards).
+    int png_level{6};               //!< Compression level of the PNG images.
+    size_t threads{0};              //!< Threads of the parallel encoder (zero means one per core).
+    ImageView view;                 //!< Part of the table drawn, and its reduction.
+};
+
+/// Steps each file's pattern with each engine of LifeCfg (bit-sliced, FixedBoard when its size has one, and 4x4 table), checking that they give the same cells.
+void benchmark_engines(const std::vector<std::string>& files, const BenchmarkSettings& settings, std::ostream& os);
+
+/// Encodes the generations of `pattern` as P3 PPM, as PNG on one thread and as PNG on a thread pool.
+void benchmark_images(const Pattern& pattern, const BenchmarkSettings& settings, std::ostream& os);
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * Result cache implementation.
+ *
+ */
+
+#include "cache.h"
+#include "census.h"
+#include "simulation.h"
+#include "../lib/trace.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace life {
+
+/// The rule the results were found with; part of every key, so results of other rules never match.
+constexpr char CACHE_RULE[]{"B3/S23"};
+
+/// Identifies the log, and the version of its layout.
+constexpr char LOG_MAGIC[4]{ 'G', 'L', 'R', 'C' };
+/// Identifies the index, and the version of its layout.
+constexpr char INDEX_MAGIC[4]{ 'G', 'L', 'R', 'I' };
+constexpr uint32_t CACHE_VERSION = 1;
+
+/// Header of the log, followed by the records.
+struct LogHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+/// A result in the log.
+struct CacheRecord {
+    uint64_t hash, check;  //!< The key.
+    uint32_t verdict;      //!< The Verdict.
+    uint32_t canonical;    //!< SimResult::canonical.
+    uint64_t generation, match, ships, core_period, population;
+    int64_t dx, dy;
+};
+
+/// Header of the index, followed by `capacity` slots.
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t capacity;  //!< Number of slots, a power of two.
+    uint64_t records;   //!< Records of the log in the index; if the log has more, the index must be rebuilt.
+};
+
+/// A slot of the index: a hash and the number of its record plus one (zero for an empty slot).
+struct IndexSlot {
+    uint64_t hash;
+    uint64_t record;
+};
+
+/// Smallest index, in slots.
+constexpr uint64_t MIN_CAPACITY = 1024;
+
+/// Builds the two hashes of a key from a sequence of words, with unrelated functions.
+struct KeyHasher {
+    CacheKey key{0x243f6a8885a308d3ULL, 0xcbf29ce484222325ULL};
+
+    void add(uint64_t word){
+        key.hash = mix64(key.hash ^ word) + 0x9e3779b97f4a7c15ULL;
+        key.check = (key.check ^ mix64(word + 0x452821e638d01377ULL)) * 0x100000001b3ULL;
+    }
+};
+
+/*!
+ * The key is made of the exact initial table (its size and every alive
+ * cell, in order), the rule, and the options a result depends on. It is
+ * not a canonical key: the edges of the table take part in the evolution,
+ * so the same shape placed elsewhere or turned around may end differently.
+ */
+CacheKey cache_key(const LifeCfg& table, const SimOptions& options){
+    KeyHasher hasher;
+    for(const char* c = CACHE_RULE; *c != '\0'; c++) hasher.add(uint8_t(*c));
+    hasher.add(table.rows());
+    hasher.add(table.cols());
+    hasher.add(options.max_gen);
+    hasher.add(options.canonical);
+    hasher.add(options.escape.enabled);
+    if(options.escape.enabled){
+        hasher.add(options.escape.check_every);
+        hasher.add(options.escape.remove);
+        hasher.add(options.escape.max_period);
+    }
+    hasher.add(table.population());
+    for(const Cell& cell : table.get_alive_cells()){
+        hasher.add(uint64_t(uint32_t(cell.row)) << 32 | uint32_t(cell.col));
+    }
+    return hasher.key;
+}
+
+ResultCache::ResultCache(const std::string& path) : m_path{path}, m_index{path + ".idx"} {}
+
+/// Reads record `n` of the log. Returns false if it isn't there.
+static bool read_record(int log, uint64_t n, CacheRecord& record){
+    off_t at = sizeof(LogHeader) + n*sizeof(CacheRecord);
+    return pread(log, &record, sizeof(record), at) == sizeof(record);
+}
+
+/// Returns true if the log starts with a valid header.
+static bool valid_log(int log){
+    LogHeader header;
+    return pread(log, &header, sizeof(header), 0) == sizeof(header)
+           and std::memcmp(header.magic, LOG_MAGIC, 4) == 0 and header.version == CACHE_VERSION;
+}
+
+/// Returns how many whole records the log holds.
+static uint64_t log_records(int log){
+    struct stat info;
+    if(fstat(log, &info) != 0 or size_t(info.st_size) < sizeof(LogHeader)) return 0;
+    return (info.st_size - sizeof(LogHeader))/sizeof(CacheRecord);
+}
+
+/// The index of the cache, memory mapped.
+class MappedIndex {
+   public:
+    /// Maps the index open in `fd`. Check valid() before using it.
+    MappedIndex(int fd, bool writable) {
+        struct stat info;
+        if(fstat(fd, &info) != 0 or size_t(info.st_size) < sizeof(IndexHeader)) return;
+        void* data = mmap(nullptr, info.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+        if(data == MAP_FAILED) return;
+        m_data = data;
+        m_size = info.st_size;
+    }
+    ~MappedIndex(){
+        if(m_data != nullptr) munmap(m_data, m_size);
+    }
+    MappedIndex(const MappedIndex&) = delete;
+    MappedIndex& operator=(const MappedIndex&) = delete;
+
+    /// Returns true if the index is mapped.
+    bool mapped(void) const { return m_data != nullptr; }
+    /// Returns true if the index is mapped, and its header and size are right.
+    bool valid(void) const {
+        if(m_data == nullptr) return false;
+        const IndexHeader& h = header();
+        return std::memcmp(h.magic, INDEX_MAGIC, 4) == 0 and h.version == CACHE_VERSION and h.capacity > 0
+               and (h.capacity & (h.capacity - 1)) == 0 and m_size == sizeof(IndexHeader) + h.capacity*sizeof(IndexSlot);
+    }
+    IndexHeader& header(void) const { return *static_cast<IndexHeader*>(m_data); }
+    IndexSlot* slots(void) const { return reinterpret_cast<IndexSlot*>(static_cast<IndexHeader*>(m_data) + 1); }
+
+    /// Returns the number of the record of `key` in `log`, or -1 if it is not there.
+    int64_t find(int log, const CacheKey& key, CacheRecord& record) const {
+        const uint64_t mask = header().capacity - 1;
+        for(uint64_t i = key.hash & mask; slots()[i].record != 0; i = (i + 1) & mask){
+            if(slots()[i].hash != key.hash) continue;
+            uint64_t n = slots()[i].record - 1;
+            if(read_record(log, n, record) and record.hash == key.hash and record.check == key.check) return n;
+        }
+        return -1;
+    }
+    /// Adds record `n`, with the given hash, to the index.
+    void add(uint64_t hash, uint64_t n){
+        const uint64_t mask = header().capacity - 1;
+        uint64_t i = hash & mask;
+        while(slots()[i].record != 0) i = (i + 1) & mask;
+        slots()[i] = IndexSlot{hash, n + 1};
+        header().records++;
+    }
+
+   private:
+    void* m_data{nullptr}; //!< The mapping.
+    size_t m_size{0};      //!< Its size.
+};
+
+/// Closes a file descriptor (releasing its lock) when it goes out of scope.
+struct FileCloser {
+    int fd;
+    ~FileCloser(){ if(fd >= 0) ::close(fd); }
+};
+
+/*!
+ * Readers share the lock of the index; with no index, nothing was stored.
+ * When the index doesn't hold every record of the log (a writer stopped
+ * between writing a record and indexing it), the log is read from start
+ * to end instead.
+ */
+bool ResultCache::find(const CacheKey& key, SimResult& result, size_t& population) const {
+    TRACE_ZONE("cache_find");
+    int log = open(m_path.c_str(), O_RDONLY);
+    FileCloser log_closer{log};
+    if(log < 0 or not valid_log(log)) return false;
+
+    CacheRecord record;
+    bool found{false};
+    int index = open(m_index.c_str(), O_RDONLY);
+    FileCloser index_closer{index};
+    if(index >= 0 and flock(index, LOCK_SH) == 0){
+        MappedIndex mapped{index, false};
+        const uint64_t records = log_records(log);
+        if(mapped.valid() and mapped.header().records == records){
+            found = mapped.find(log, key, record) >= 0;
+        }
+        else{
+            for(uint64_t n{0u}; n < records and not found; n++){
+                found = read_record(log, n, record) and record.hash == key.hash and record.check == key.check;
+            }
+        }
+    }
+    if(not found) return false;
+
+    result = SimResult{};
+    result.verdict = Verdict(record.verdict);
+    result.generation = record.generation;
+    result.match = record.match;
+    result.canonical = record.canonical != 0;
+    result.dx = record.dx;
+    result.dy = record.dy;
+    result.ships = record.ships;
+    result.core_period = record.core_period;
+    population = record.population;
+    return true;
+}
+
+/// Rebuilds the index open in `index` from the first `records` records of `log`, with room for more.
+static bool rebuild_index(int index, int log, uint64_t records){
+    uint64_t capacity = MIN_CAPACITY;
+    while(capacity < 4*(records + 1)) capacity *= 2;
+    if(ftruncate(index, 0) != 0 or ftruncate(index, sizeof(IndexHeader) + capacity*sizeof(IndexSlot)) != 0) return false;
+    MappedIndex mapped{index, true};
+    if(not mapped.mapped()) return false;
+    IndexHeader& header = mapped.header();
+    std::memcpy(header.magic, INDEX_MAGIC, 4);
+    header.version = CACHE_VERSION;
+    header.capacity = capacity;
+    header.records = 0;
+    CacheRecord record;
+    for(uint64_t n{0u}; n < records; n++){
+        if(not read_record(log, n, record)) return false;
+        mapped.add(record.hash, n);
+    }
+    return true;
+}
+
+/*!
+ * Writers hold the lock of the index alone. The record is written to the
+ * log before it is indexed, and the index is rebuilt from the log when it
+ * is missing, out of date or half full, so it never points to a record
+ * that isn't there.
+ */
+bool ResultCache::insert(const CacheKey& key, const SimResult& result, size_t population) const {
+    TRACE_ZONE("cache_insert");
+    int index = open(m_index.c_str(), O_RDWR | O_CREAT, 0644);
+    FileCloser index_closer{index};
+    if(index < 0 or flock(index, LOCK_EX) != 0) return false;
+    int log = open(m_path.c_str(), O_RDWR | O_CREAT, 0644);
+    FileCloser log_closer{log};
+    if(log < 0) return false;
+
+    if(not valid_log(log)){
+        if(log_records(log) > 0) return false;  // Not a cache: leave it alone.
+        LogHeader header;
+        std::memcpy(header.magic, LOG_MAGIC, 4);
+        header.version = CACHE_VERSION;
+        if(ftruncate(log, 0) != 0 or pwrite(log, &header, sizeof(header), 0) != sizeof(header)) return false;
+    }
+    // A record cut short by a crash is dropped, so the next one lands in its place.
+    const uint64_t records = log_records(log);
+    if(ftruncate(log, sizeof(LogHeader) + records*sizeof(CacheRecord)) != 0) return false;
+
+    {
+        MappedIndex mapped{index, false};
+        bool fresh = mapped.valid() and mapped.header().records == records
+                     and 2*(records + 1) <= mapped.header().capacity;
+        if(not fresh and not rebuild_index(index, log, records)) return false;
+    }
+    MappedIndex mapped{index, true};
+    if(not mapped.valid()) return false;
+    CacheRecord record;
+    if(mapped.find(log, key, record) >= 0) return true;  // Stored by another process meanwhile.
+
+    record = CacheRecord{};
+    record.hash = key.hash;
+    record.check = key.check;
+    record.verdict = uint32_t(result.verdict);
+    record.canonical = result.canonical;
+    record.generation = result.generation;
+    record.match = result.match;
+    record.ships = result.ships;
+    record.core_period = result.core_period;
+    record.population = population;
+    record.dx = result.dx;
+    record.dy = result.dy;
+    off_t at = sizeof(LogHeader) + records*sizeof(CacheRecord);
+    if(pwrite(log, &record, sizeof(record), at) != sizeof(record)) return false;
+    mapped.add(key.hash, records);
+    return true;
+}
+
+}  // namespace life
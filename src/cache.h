@@ -0,0 +1,61 @@
+//! Persistent cache of simulation results.
+/*!
+ * @file cache.h
+ *
+ * @details Results of headless and batch runs are kept on disk, keyed by
+ * the initial table, the rule and the settings that change the result, so
+ * a pattern that was already simulated (by this or another process) is
+ * answered at once.
+ *
+ * The cache is an append-only log of fixed size records and an index, a
+ * hash table of the records that is memory mapped while it is used. Both
+ * are guarded by flock() on the index: lookups share the lock and inserts
+ * take it alone, so any number of processes can use the same cache.
+ */
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "life.h"
+
+namespace life {
+
+struct SimOptions;
+struct SimResult;
+
+/// Settings of the result cache.
+struct CacheSettings {
+    bool enabled{false};             //!< Whether results are looked up and stored.
+    std::string path{"glife.cache"}; //!< The log; the index is the same path with ".idx" appended.
+};
+
+/// Identifies a simulation: two independent 64-bit hashes of everything its result depends on.
+struct CacheKey {
+    uint64_t hash{0};  //!< Hash used by the index.
+    uint64_t check{0}; //!< Second hash, compared on a hit so that index collisions don't matter.
+};
+
+/// Returns the key of simulating `table` (before its first step) with `options`.
+CacheKey cache_key(const LifeCfg& table, const SimOptions& options);
+
+/// The results stored on disk.
+class ResultCache {
+   public:
+    explicit ResultCache(const std::string& path);
+
+    /// Looks `key` up; on a hit, sets `result` and the final `population` and returns true.
+    bool find(const CacheKey& key, SimResult& result, size_t& population) const;
+    /// Stores the result of `key`, unless it is there already. Returns false if the cache cannot be written.
+    bool insert(const CacheKey& key, const SimResult& result, size_t population) const;
+
+   private:
+    std::string m_path;  //!< The log.
+    std::string m_index; //!< The index.
+};
+
+}  // namespace life
+
+#endif
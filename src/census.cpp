@@ -0,0 +1,267 @@
+/**
+ * Canonical forms implementation.
+ *
+ */
+
+#include "census.h"
+#include "../lib/trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace life {
+
+/// FNV-1a hash of the packed (row, col) pairs of `cells`, which must be sorted.
+static uint64_t hash_cells(const std::vector<uint64_t>& packed){
+    uint64_t hash{14695981039346656037ull};
+    for(auto cell : packed){
+        for(int byte{0}; byte < 8; byte++){
+            hash ^= (cell >> (8*byte)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash == 0 ? 1 : hash; // Zero is kept for the empty pattern.
+}
+
+/// Returns the cells translated to the origin of their bounding box, as sorted packed coordinates.
+static std::vector<uint64_t> normalise(const std::vector<Cell>& cells, int& top, int& left){
+    top = INT_MAX;
+    left = INT_MAX;
+    for(const auto& cell : cells){
+        top = std::min(top, cell.row);
+        left = std::min(left, cell.col);
+    }
+    std::vector<uint64_t> packed;
+    packed.reserve(cells.size());
+    for(const auto& cell : cells){
+        packed.push_back(uint64_t(cell.row - top) << 32 | uint64_t(cell.col - left));
+    }
+    std::sort(packed.begin(), packed.end());
+    return packed;
+}
+
+uint64_t canonical_hash(const std::vector<Cell>& cells){
+    if(cells.empty()) return 0;
+
+    // Bounding box of the cells.
+    int top{INT_MAX}, left{INT_MAX}, bottom{INT_MIN}, right{INT_MIN};
+    for(const auto& cell : cells){
+        top = std::min(top, cell.row);
+        bottom = std::max(bottom, cell.row);
+        left = std::min(left, cell.col);
+        right = std::max(right, cell.col);
+    }
+    const int64_t h = bottom - top, w = right - left; // Last row and column, after translation.
+
+    uint64_t best{UINT64_MAX};
+    std::vector<uint64_t> packed(cells.size());
+    for(int sym{0}; sym < SYMMETRIES; sym++){
+        for(size_t i{0u}; i < cells.size(); i++){
+            auto [tr, tc] = apply_symmetry(sym, cells[i].row - top, cells[i].col - left, h, w);
+            packed[i] = uint64_t(tr) << 32 | uint64_t(tc);
+        }
+        std::sort(packed.begin(), packed.end());
+        best = std::min(best, hash_cells(packed));
+    }
+    return best;
+}
+
+uint64_t translated_hash(const std::vector<Cell>& cells){
+    if(cells.empty()) return 0;
+    int top, left;
+    return hash_cells(normalise(cells, top, left));
+}
+
+/// Union-find with path halving, over the indices of the cells.
+class DisjointSets {
+   public:
+    explicit DisjointSets(size_t n) : m_parent(n) { std::iota(m_parent.begin(), m_parent.end(), 0u); }
+    uint32_t find(uint32_t x){
+        while(m_parent[x] != x){
+            m_parent[x] = m_parent[m_parent[x]];
+            x = m_parent[x];
+        }
+        return x;
+    }
+    void unite(uint32_t a, uint32_t b){
+        a = find(a);
+        b = find(b);
+        if(a != b) m_parent[std::max(a, b)] = std::min(a, b);
+    }
+   private:
+    std::vector<uint32_t> m_parent;
+};
+
+std::vector<std::vector<Cell>> split_objects(std::vector<Cell> cells){
+    // Packed coordinates sort row by row, which is what the sweep below needs.
+    auto packed = [](const Cell& c){ return uint64_t(uint32_t(c.row)) << 32 | uint32_t(c.col); };
+    if(not std::is_sorted(cells.begin(), cells.end(), [&](const Cell& a, const Cell& b){ return packed(a) < packed(b); })){
+        std::sort(cells.begin(), cells.end(), [&](const Cell& a, const Cell& b){ return packed(a) < packed(b); });
+    }
+
+    // Sweeps the cells row by row. Each cell is joined to its left neighbour and to the
+    // (up to 3) neighbours in the row above, found by a pointer that only moves forward.
+    DisjointSets sets{cells.size()};
+    size_t prev_begin{0}, prev_end{0}; // Cells of the row above.
+    size_t row_begin{0};               // First cell of the current row.
+    size_t above{0};                   // Pointer into the row above.
+    for(size_t i{0u}; i < cells.size(); i++){
+        if(i > 0 and cells[i].row != cells[i-1].row){
+            bool adjacent = cells[i].row == cells[i-1].row + 1;
+            prev_begin = adjacent ? row_begin : i; // Empty if the row above has no cells.
+            prev_end = i;
+            row_begin = i;
+            above = prev_begin;
+        }
+        if(i > row_begin and cells[i-1].col + 1 == cells[i].col){
+            sets.unite(i, i-1);
+        }
+        while(above < prev_end and cells[above].col < cells[i].col - 1) above++;
+        for(size_t k{above}; k < prev_end and cells[k].col <= cells[i].col + 1; k++){
+            sets.unite(i, k);
+        }
+    }
+
+    // Gathers the cells of each component, in the order of their first cell.
+    std::vector<std::vector<Cell>> objects;
+    std::vector<uint32_t> object_of(cells.size());
+    for(size_t i{0u}; i < cells.size(); i++){
+        auto root = sets.find(i);
+        if(root == i){
+            object_of[i] = objects.size();
+            objects.emplace_back();
+        }
+        objects[object_of[root]].push_back(cells[i]);
+    }
+    return objects;
+}
+
+/// Common names of some objects, by the canonical hash of one of their phases.
+static const std::unordered_map<uint64_t, std::string>& known_objects(void){
+    static const std::unordered_map<uint64_t, std::string> names = []{
+        const std::vector<std::pair<std::string, std::vector<std::string>>> drawings{
+            { "block", { "oo", "oo" } },
+            { "beehive", { ".oo.", "o..o", ".oo." } },
+            { "loaf", { ".oo.", "o..o", ".o.o", "..o." } },
+            { "boat", { "oo.", "o.o", ".o." } },
+            { "ship", { "oo.", "o.o", ".oo" } },
+            { "tub", { ".o.", "o.o", ".o." } },
+            { "pond", { ".oo.", "o..o", "o..o", ".oo." } },
+            { "long boat", { "oo..", "o.o.", ".o.o", "..o." } },
+            { "barge", { ".o..", "o.o.", ".o.o", "..o." } },
+            { "snake", { "oo.o", "o.oo" } },
+            { "mango", { ".oo..", "o..o.", ".o..o", "..oo." } },
+            { "aircraft carrier", { "oo..", "o..o", "..oo" } },
+            { "blinker", { "ooo" } },
+            { "toad", { ".ooo", "ooo." } },
+            { "beacon", { "oo..", "oo..", "..oo", "..oo" } },
+            { "glider", { ".o.", "..o", "ooo" } },
+            { "lightweight spaceship", { ".o..o", "o....", "o...o", "oooo." } },
+            { "middleweight spaceship", { "...o..", ".o...o", "o.....", "o....o", "ooooo." } },
+            { "heavyweight spaceship", { "...oo..", ".o....o", "o......", "o.....o", "oooooo." } },
+        };
+        std::unordered_map<uint64_t, std::string> table;
+        for(const auto& [name, rows] : drawings){
+            std::vector<Cell> cells;
+            for(size_t r{0u}; r < rows.size(); r++){
+                for(size_t c{0u}; c < rows[r].size(); c++){
+                    if(rows[r][c] == 'o') cells.push_back({int(r), int(c)});
+                }
+            }
+            table[canonical_hash(cells)] = name;
+        }
+        return table;
+    }();
+    return names;
+}
+
+ObjectInfo identify_object(const std::vector<Cell>& object, unsigned long max_period){
+    ObjectInfo info;
+    info.hash = canonical_hash(object);
+    info.population = object.size();
+    if(object.empty()) return info;
+
+    // Places the object on a table large enough for it to move `max_period` cells in any direction.
+    int top, left;
+    auto initial = normalise(object, top, left);
+    int height{0}, width{0};
+    for(auto cell : initial){
+        height = std::max(height, int(cell >> 32) + 1);
+        width = std::max(width, int(cell & 0xFFFFFFFF) + 1);
+    }
+    const int margin = max_period + 2;
+    std::vector<Cell> placed;
+    for(const auto& cell : object) placed.push_back({cell.row - top + margin, cell.col - left + margin});
+    LifeCfg table(std::move(placed), height + 2*margin, width + 2*margin);
+
+    const auto& names = known_objects();
+    std::string name;
+    for(unsigned long gen{1u}; gen <= max_period and not table.is_empty(); gen++){
+        auto hash = canonical_hash(table.get_alive_cells());
+        if(name.empty() and names.count(hash)) name = names.at(hash);
+        if(hash < info.hash){
+            info.hash = hash;
+            info.population = table.population();
+        }
+
+        table.step();
+        int t, l;
+        if(normalise(table.get_alive_cells(), t, l) == initial){
+            info.period = gen;
+            info.dx = l - margin;
+            info.dy = t - margin;
+            break;
+        }
+    }
+
+    if(info.period == 0){
+        // Keeps the hash and population of the given phase, since the others are not known to be the same object.
+        info.hash = canonical_hash(object);
+        info.population = object.size();
+        info.name = "unidentified";
+    }
+    else if(not name.empty()) info.name = name;
+    else if(info.dx != 0 or info.dy != 0) info.name = "spaceship";
+    else info.name = info.period == 1 ? "still life" : "oscillator";
+    return info;
+}
+
+std::vector<CensusEntry> take_census(const std::vector<Cell>& cells, unsigned long max_period){
+    TRACE_ZONE("take_census");
+    std::unordered_map<uint64_t, CensusEntry> kinds;   // Entries by the hash of their smallest phase.
+    std::unordered_map<uint64_t, uint64_t> phase_kind; // Hash of each phase seen -> hash of its kind.
+
+    for(const auto& object : split_objects(cells)){
+        auto hash = canonical_hash(object);
+        auto it = phase_kind.find(hash);
+        if(it == phase_kind.end()){
+            // First time this phase is seen; identifying it is the only costly step.
+            auto info = identify_object(object, max_period);
+            it = phase_kind.emplace(hash, info.hash).first;
+            kinds.try_emplace(info.hash, CensusEntry{info, 0});
+        }
+        kinds.at(it->second).count++;
+    }
+
+    std::vector<CensusEntry> census;
+    for(auto& [hash, entry] : kinds) census.push_back(std::move(entry));
+    std::sort(census.begin(), census.end(), [](const CensusEntry& a, const CensusEntry& b){
+        return a.count > b.count or (a.count == b.count and a.object.hash < b.object.hash);
+    });
+    return census;
+}
+
+void print_census(std::ostream& os, const std::vector<CensusEntry>& census){
+    for(const auto& entry : census){
+        const auto& obj = entry.object;
+        os << "  " << entry.count << " x " << obj.name << " (" << obj.population << (obj.population == 1 ? " cell" : " cells");
+        if(obj.period > 1) os << ", period " << obj.period;
+        if(obj.dx != 0 or obj.dy != 0) os << ", moving (" << obj.dx << ", " << obj.dy << ")";
+        os << ")\n";
+    }
+}
+
+}  // namespace life
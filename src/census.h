@@ -0,0 +1,100 @@
+//! Canonical forms of life patterns.
+/*!
+ * @file census.h
+ *
+ * @details Functions to identify a pattern regardless of its position
+ * and orientation on the table, so equal objects can be tallied together,
+ * and to take the census of the objects in a stabilised table.
+ */
+
+#ifndef _CENSUS_H_
+#define _CENSUS_H_
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "life.h"
+
+namespace life {
+
+/// Mixes the bits of `x` (the finalizer of splitmix64): nearby inputs give unrelated outputs.
+inline uint64_t mix64(uint64_t x){
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/// Number of symmetries of the square: the identity, the rotations and the reflections.
+constexpr int SYMMETRIES = 8;
+
+/// Moves cell (r, c) of a box whose last row is `h` and last column is `w` by one of the SYMMETRIES.
+/*!
+ * The result is inside the box turned by the symmetry, whose last row and
+ * column are swapped by the odd rotations and the transpositions. Both the
+ * census and the canonical keys of LifeCfg number the symmetries this way.
+ */
+inline std::pair<int64_t, int64_t> apply_symmetry(int symmetry, int64_t r, int64_t c, int64_t h, int64_t w){
+    switch(symmetry){
+        case 0: return {r, c};          // Identity.
+        case 1: return {c, h - r};      // Rotation by 90 degrees.
+        case 2: return {h - r, w - c};  // Rotation by 180 degrees.
+        case 3: return {w - c, r};      // Rotation by 270 degrees.
+        case 4: return {r, w - c};      // Horizontal reflection.
+        case 5: return {h - r, c};      // Vertical reflection.
+        case 6: return {c, r};          // Transposition.
+        default: return {w - c, h - r}; // Anti-transposition.
+    }
+}
+
+/// Returns a hash of `cells` that is the same for every translation, rotation and reflection of them.
+/*!
+ * The cells are translated to the origin of their bounding box and hashed
+ * under each of the 8 symmetries of the square; the smallest hash is kept.
+ * An empty pattern hashes to zero.
+ */
+uint64_t canonical_hash(const std::vector<Cell>& cells);
+
+/// Returns a hash of `cells` that is the same for every translation of them, but not for rotations or reflections.
+uint64_t translated_hash(const std::vector<Cell>& cells);
+
+/// Splits `cells` into its 8-connected components, using a union-find over their packed coordinates.
+std::vector<std::vector<Cell>> split_objects(std::vector<Cell> cells);
+
+/// What an object is, found by evolving it in isolation.
+struct ObjectInfo {
+    uint64_t hash{0};        //!< Canonical hash, the smallest among the phases.
+    std::string name;        //!< Common name, or its kind if the object is not a known one.
+    size_t population{0};    //!< Population of the phase with the smallest hash.
+    unsigned long period{0}; //!< Period; zero if it did not recur within the limit.
+    int dx{0}, dy{0};        //!< Displacement per period (spaceships only).
+};
+
+/// Returns what `object` is, evolving it in isolation for up to `max_period` generations.
+ObjectInfo identify_object(const std::vector<Cell>& object, unsigned long max_period = 64);
+
+/// One kind of object found by a census.
+struct CensusEntry {
+    ObjectInfo object;       //!< The object.
+    unsigned long count{0};  //!< How many times it occurs.
+};
+
+/// Splits `cells` into objects and counts each kind, most common first.
+/*!
+ * Objects are identified once per distinct canonical hash, so a census of
+ * many copies of a few objects costs little more than splitting them.
+ * Objects whose cells touch are taken as a single object; if such an object
+ * does not recur within `max_period` generations it is reported as unidentified.
+ */
+std::vector<CensusEntry> take_census(const std::vector<Cell>& cells, unsigned long max_period = 64);
+
+/// Prints a census, one kind of object per line.
+void print_census(std::ostream& os, const std::vector<CensusEntry>& census);
+
+}  // namespace life
+
+#endif
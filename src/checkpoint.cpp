@@ -0,0 +1,181 @@
+/**
+ * Checkpoint implementation.
+ *
+ */
+
+#include "checkpoint.h"
+#include "../lib/trace.h"
+
+#include <cstdio>
+#include <unistd.h>
+
+namespace life {
+
+/// Identifies a checkpoint file, and the version of its layout (3: symmetries numbered as in apply_symmetry()).
+constexpr char CHECKPOINT_MAGIC[4]{ 'G', 'L', 'C', 'K' };
+constexpr uint32_t CHECKPOINT_VERSION = 3;
+
+/// Writes the bytes of a trivially copyable value.
+template <typename T>
+static void put(std::string& out, const T& value){
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Reads the bytes of a trivially copyable value. Returns false if the input is too short.
+template <typename T>
+static bool take(std::ifstream& in, T& value){
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+/*!
+ * Layout (native byte order): magic, version, gen, rows, cols, ships,
+ * number of cells followed by their (row, col) pairs, whether the database
+ * is canonical, and number of database entries followed by each key
+ * (length and bytes), generation, symmetry, top and left.
+ */
+bool save_checkpoint(const std::string& file, const Checkpoint& checkpoint){
+    TRACE_ZONE("save_checkpoint");
+    std::string data;
+    data.append(CHECKPOINT_MAGIC, 4);
+    put(data, CHECKPOINT_VERSION);
+    put(data, uint64_t(checkpoint.gen));
+    put(data, uint64_t(checkpoint.rows));
+    put(data, uint64_t(checkpoint.cols));
+    put(data, uint64_t(checkpoint.ships));
+    put(data, uint64_t(checkpoint.cells.size()));
+    for(const auto& cell : checkpoint.cells){
+        put(data, int32_t(cell.row));
+        put(data, int32_t(cell.col));
+    }
+    put(data, uint8_t(checkpoint.database.canonical()));
+    put(data, uint64_t(checkpoint.database.size()));
+    for(const auto& [key, record] : checkpoint.database){
+        put(data, uint32_t(key.size()));
+        data += key;
+        put(data, uint64_t(record.gen));
+        put(data, record.placement.symmetry);
+        put(data, int64_t(record.placement.top));
+        put(data, int64_t(record.placement.left));
+    }
+
+    // The file is only replaced once the new one is safely on disk.
+    auto temp = file + ".tmp";
+    FILE* out = std::fopen(temp.c_str(), "wb");
+    if(out == nullptr) return false;
+    bool ok = std::fwrite(data.data(), 1, data.size(), out) == data.size()
+        and std::fflush(out) == 0
+        and fsync(fileno(out)) == 0;
+    ok = std::fclose(out) == 0 and ok;
+    if(not ok or std::rename(temp.c_str(), file.c_str()) != 0){
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const std::string& file, Checkpoint& checkpoint){
+    std::ifstream in{file, std::ios::binary};
+    if(not in.is_open()) return false;
+
+    char magic[4];
+    uint32_t version;
+    uint64_t gen, rows, cols, ships, n_cells, n_entries;
+    if(not in.read(magic, 4) or std::memcmp(magic, CHECKPOINT_MAGIC, 4) != 0) return false;
+    if(not take(in, version) or version != CHECKPOINT_VERSION) return false;
+    if(not (take(in, gen) and take(in, rows) and take(in, cols) and take(in, ships) and take(in, n_cells))) return false;
+
+    checkpoint = Checkpoint{};
+    checkpoint.gen = gen;
+    checkpoint.rows = rows;
+    checkpoint.cols = cols;
+    checkpoint.ships = ships;
+    checkpoint.cells.reserve(n_cells);
+    for(uint64_t i{0u}; i < n_cells; i++){
+        int32_t row, col;
+        if(not (take(in, row) and take(in, col))) return false;
+        checkpoint.cells.push_back({row, col});
+    }
+    uint8_t canonical;
+    if(not take(in, canonical) or not take(in, n_entries)) return false;
+    checkpoint.database = SimDatabase{canonical != 0};
+    std::string key;
+    for(uint64_t i{0u}; i < n_entries; i++){
+        uint32_t length;
+        uint64_t key_gen;
+        Placement placement;
+        int64_t top, left;
+        if(not take(in, length)) return false;
+        key.resize(length);
+        if(not in.read(key.data(), length) or not take(in, key_gen)) return false;
+        if(not (take(in, placement.symmetry) and take(in, top) and take(in, left))) return false;
+        placement.top = top;
+        placement.left = left;
+        checkpoint.database.insert(key, key_gen, placement);
+    }
+    return true;
+}
+
+/*============================================= CheckpointWriter =============================================*/
+
+CheckpointWriter::CheckpointWriter(const CheckpointSettings& settings)
+    : m_settings{settings},
+      m_last{std::chrono::steady_clock::now()}
+{
+    if(m_settings.enabled()){
+        m_thread = std::thread([this]{ work(); });
+    }
+}
+
+CheckpointWriter::~CheckpointWriter(){
+    if(not m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+bool CheckpointWriter::due(unsigned long gen){
+    if(not m_settings.enabled()) return false;
+    auto now = std::chrono::steady_clock::now();
+    bool due = (m_settings.every_gen > 0 and gen % m_settings.every_gen == 0)
+        or (m_settings.every_sec > 0 and now - m_last >= std::chrono::seconds(m_settings.every_sec));
+    if(due) m_last = now;
+    return due;
+}
+
+/// The records of a dropped checkpoint are kept, since later ones only bring the records added after it.
+void CheckpointWriter::submit(Checkpoint&& checkpoint){
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_new_records.push_back(std::move(checkpoint.database));
+        m_pending = std::make_unique<Checkpoint>(std::move(checkpoint));
+    }
+    m_cv.notify_one();
+}
+
+void CheckpointWriter::work(void){
+    while(true){
+        std::unique_ptr<Checkpoint> checkpoint;
+        std::vector<SimDatabase> new_records;
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_cv.wait(lock, [this]{ return m_stop or m_pending; });
+            if(not m_pending) return;
+            checkpoint = std::move(m_pending);
+            new_records.swap(m_new_records);
+        }
+        // The first records also tell whether the database is canonical.
+        if(m_database.size() == 0 and new_records.size() > 0) m_database = SimDatabase{new_records.front().canonical()};
+        for(auto& records : new_records) m_database.merge(records);
+        // The database is lent to the checkpoint while it is written.
+        checkpoint->database = std::move(m_database);
+        if(not save_checkpoint(m_settings.path, *checkpoint)){
+            std::cerr << "Cannot write checkpoint to " << m_settings.path << "\n";
+        }
+        m_database = std::move(checkpoint->database);
+    }
+}
+
+}  // namespace life
@@ -0,0 +1,85 @@
+//! Checkpoints of long simulations.
+/*!
+ * @file checkpoint.h
+ *
+ * @details Saves the whole state of a simulation (generation, alive cells
+ * and cycle detection database) into a compact binary file, so a long run
+ * can be resumed after a crash or preemption with the very same results.
+ */
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "life.h"
+
+namespace life {
+
+/// Settings of the periodic checkpoints.
+struct CheckpointSettings {
+    std::string path{"glife.ckpt"}; //!< File the checkpoints are written to.
+    unsigned long every_gen{0};     //!< Write one every N generations (zero disables).
+    unsigned long every_sec{0};     //!< Write one every N seconds (zero disables).
+
+    /// Returns true if any kind of checkpoint is enabled.
+    bool enabled(void) const { return every_gen > 0 or every_sec > 0; }
+};
+
+/// The state of a simulation at a given generation.
+struct Checkpoint {
+    unsigned long gen{1};      //!< Generation of the table.
+    size_t rows{0}, cols{0};   //!< Dimensions of the table.
+    std::vector<Cell> cells;   //!< Alive cells of the table.
+    SimDatabase database;      //!< Every generation seen so far.
+    size_t ships{0};           //!< Escaping ships deleted so far.
+};
+
+/// Writes `checkpoint` to `file` atomically: to a temporary file first, then renamed over it.
+bool save_checkpoint(const std::string& file, const Checkpoint& checkpoint);
+/// Reads a checkpoint from `file`. Returns false if it cannot be read or is not a checkpoint.
+bool load_checkpoint(const std::string& file, Checkpoint& checkpoint);
+
+/// Writes checkpoints on a background thread, so the simulation doesn't wait for the disk.
+class CheckpointWriter {
+   public:
+    explicit CheckpointWriter(const CheckpointSettings& settings);
+    /// Writes the checkpoint still waiting, if any, and stops the thread.
+    ~CheckpointWriter();
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /// Returns true if a checkpoint should be taken at generation `gen`.
+    bool due(unsigned long gen);
+    /// Hands a checkpoint to the writer thread. A previous one not written yet is dropped.
+    /*!
+     * The database of `checkpoint` holds only the records added since the
+     * previous one (every record, for the first); the writer thread keeps
+     * the rest, so the simulation never copies the whole database.
+     */
+    void submit(Checkpoint&& checkpoint);
+
+   private:
+    /// Loop of the writer thread.
+    void work(void);
+
+    CheckpointSettings m_settings;                  //!< The settings.
+    std::chrono::steady_clock::time_point m_last;   //!< When the last checkpoint was taken.
+    std::unique_ptr<Checkpoint> m_pending;          //!< Checkpoint waiting to be written.
+    std::vector<SimDatabase> m_new_records;         //!< Records submitted and not yet added to m_database.
+    SimDatabase m_database;                         //!< Every record submitted so far (writer thread only).
+    std::mutex m_mutex;                             //!< Guards the pending checkpoint and the stop flag.
+    std::condition_variable m_cv;                   //!< Wakes the writer thread up.
+    bool m_stop{false};                             //!< Set when the writer is being destroyed.
+    std::thread m_thread;                           //!< The writer thread (only if enabled).
+};
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,159 @@
+//! Settings of the simulation, read from the INI file.
+/*!
+ * @file config.h
+ *
+ * @details Struct GlifeConfig, with every setting the program reads, and
+ * its schema: the section, field, type, fall back value and valid values of
+ * each one. The schema is checked at compile time, and the INI file is
+ * checked against it once, at start up, so misspelled fields and values out
+ * of range are reported instead of silently falling back.
+ */
+
+#ifndef _CONFIG_H_
+#define _CONFIG_H_
+
+#include <array>
+#include <string>
+
+#include "../lib/tip.h"
+
+namespace life {
+
+/// Every setting of the program.
+struct GlifeConfig {
+    // [ROOT]
+    std::string input_cfg;     //!< File with the initial table.
+    int max_gen;               //!< Generations to simulate (0 for no limit).
+    // [Image]
+    bool generate_image;       //!< Whether images are generated, instead of text.
+    std::string alive;         //!< Color of alive cells.
+    std::string bkg;           //!< Color of dead cells.
+    int block_size;            //!< Size of a cell, in pixels.
+    std::string image_path;    //!< Where images are saved.
+    std::string image_format;  //!< Format of the images: ppm, png or rawvideo.
+    int png_level;             //!< Compression level of PNG images (0 to 9; streamed ones only tell 0 from the rest).
+    int image_threads;         //!< Threads encoding PNG images (0 for one per core).
+    std::string viewport;      //!< Part of the table drawn, as "x,y,w,h" (empty for all of it).
+    std::string scale;         //!< Reduction of the images, as "1/N".
+    bool image_streaming;      //!< Write images row by row from the cells (P6 and streamed PNG).
+    // [Text]
+    int fps;                   //!< Generations printed per second (0 for no limit).
+    std::string style;         //!< How the table is printed: ascii, halfblock or braille.
+    // [Run]
+    std::string mode;          //!< text, image, headless, batch, soup or benchmark; auto follows generate_image.
+    int dump_every;            //!< Every how many generations a headless run saves one.
+    bool dump_last;            //!< Whether a headless run saves its last generation.
+    std::string dump_format;   //!< Format of the saved generations: ppm, png, rle or rawvideo.
+    bool canonical;            //!< Whether cycles are also found in translated copies (moving patterns).
+    // [Video]
+    std::string video_output;  //!< Where raw frames go: "-" for the standard output, or a file or named pipe.
+    std::string video_command; //!< Command that reads the raw frames (empty for none).
+    int video_fps;             //!< Frames per second of the video.
+    // [Benchmark]
+    int bench_generations;     //!< Generations used by the benchmark.
+    std::string bench_patterns; //!< Directory or glob of the patterns the engines are compared on (empty for none).
+    // [Batch]
+    std::string batch_input;   //!< Directory or glob of a batch run.
+    int batch_threads;         //!< Threads of a batch run (0 for one per core).
+    std::string batch_summary; //!< Where the batch summary is written.
+    // [Soup]
+    int soup_rows;             //!< Rows of each soup.
+    int soup_cols;             //!< Columns of each soup.
+    TIP::real_t soup_density;  //!< Chance of each cell starting alive.
+    int soup_seed;             //!< Seed of the soups.
+    int soup_count;            //!< How many soups are run.
+    int soup_max_gen;          //!< Generations until a soup is considered unstable.
+    int soup_threads;          //!< Threads of a soup search (0 for one per core).
+    int soup_top;              //!< How many objects are listed.
+    // [Escape]
+    bool escape_enabled;       //!< Whether escaping ships are looked for.
+    int escape_check_every;    //!< Every how many generations the table is checked.
+    bool escape_remove;        //!< Delete the ships, instead of stopping.
+    int escape_max_period;     //!< Largest period looked for.
+    // [Checkpoint]
+    std::string checkpoint_path; //!< Checkpoint file.
+    int checkpoint_every_gen;  //!< Saves every N generations (0 to disable).
+    int checkpoint_every_sec;  //!< Saves every N seconds (0 to disable).
+    // [Metrics]
+    bool metrics_enabled;      //!< Whether per generation metrics are recorded.
+    std::string metrics_path;  //!< File the metrics are written to.
+    std::string metrics_format; //!< csv or binary.
+    int metrics_buffer;        //!< Samples kept in memory before being written.
+    // [Cache]
+    bool cache_enabled;        //!< Whether results of headless and batch runs are kept on disk.
+    std::string cache_path;    //!< The cache file (its index is the same path with ".idx").
+};
+
+/// Names of the colors of life::color_pallet, as accepted by the INI file.
+constexpr std::string_view color_choices{"black|white|dark_green|red|green|blue|crimson|light_blue|light_grey"
+                                         "|deep_sky_blue|dodger_blue|steel_blue|yellow|light_yellow"};
+
+using ConfigField = TIP::Field<GlifeConfig>;
+/// Schema of GlifeConfig: the fields of the INI file and their fall back values.
+constexpr std::array config_schema{
+    ConfigField{ "ROOT", "input_cfg", &GlifeConfig::input_cfg, "" },
+    ConfigField{ "ROOT", "max_gen", &GlifeConfig::max_gen, 0, 0 },
+
+    ConfigField{ "image", "generate_image", &GlifeConfig::generate_image, false },
+    ConfigField{ "image", "alive", &GlifeConfig::alive, "red", color_choices },
+    ConfigField{ "image", "bkg", &GlifeConfig::bkg, "green", color_choices },
+    ConfigField{ "image", "block_size", &GlifeConfig::block_size, 10, 1, 1000 },
+    ConfigField{ "image", "path", &GlifeConfig::image_path, "" },
+    ConfigField{ "image", "format", &GlifeConfig::image_format, "ppm", "ppm|png|rawvideo" },
+    ConfigField{ "image", "png_level", &GlifeConfig::png_level, 6, 0, 9 },
+    ConfigField{ "image", "threads", &GlifeConfig::image_threads, 0, 0 },
+    ConfigField{ "image", "viewport", &GlifeConfig::viewport, "" },
+    ConfigField{ "image", "scale", &GlifeConfig::scale, "1" },
+    ConfigField{ "image", "streaming", &GlifeConfig::image_streaming, false },
+
+    ConfigField{ "text", "fps", &GlifeConfig::fps, 10, 0 },
+    ConfigField{ "text", "style", &GlifeConfig::style, "ascii", "ascii|halfblock|braille" },
+
+    ConfigField{ "run", "mode", &GlifeConfig::mode, "auto", "auto|text|image|headless|batch|soup|benchmark" },
+    ConfigField{ "run", "dump_every", &GlifeConfig::dump_every, 0, 0 },
+    ConfigField{ "run", "dump_last", &GlifeConfig::dump_last, false },
+    ConfigField{ "run", "dump_format", &GlifeConfig::dump_format, "ppm", "ppm|png|rle|rawvideo" },
+    ConfigField{ "run", "canonical", &GlifeConfig::canonical, false },
+
+    ConfigField{ "video", "output", &GlifeConfig::video_output, "-" },
+    ConfigField{ "video", "command", &GlifeConfig::video_command, "" },
+    ConfigField{ "video", "fps", &GlifeConfig::video_fps, 30, 1 },
+
+    ConfigField{ "benchmark", "generations", &GlifeConfig::bench_generations, 100, 1 },
+    ConfigField{ "benchmark", "patterns", &GlifeConfig::bench_patterns, "data" },
+
+    ConfigField{ "batch", "input", &GlifeConfig::batch_input, "data" },
+    ConfigField{ "batch", "threads", &GlifeConfig::batch_threads, 0, 0 },
+    ConfigField{ "batch", "summary", &GlifeConfig::batch_summary, "summary.csv" },
+
+    ConfigField{ "soup", "rows", &GlifeConfig::soup_rows, 16, 1 },
+    ConfigField{ "soup", "cols", &GlifeConfig::soup_cols, 16, 1 },
+    ConfigField{ "soup", "density", &GlifeConfig::soup_density, 0.5f, 0, 1 },
+    ConfigField{ "soup", "seed", &GlifeConfig::soup_seed, 1 },
+    ConfigField{ "soup", "count", &GlifeConfig::soup_count, 1000, 0 },
+    ConfigField{ "soup", "max_gen", &GlifeConfig::soup_max_gen, 1000, 1 },
+    ConfigField{ "soup", "threads", &GlifeConfig::soup_threads, 0, 0 },
+    ConfigField{ "soup", "top", &GlifeConfig::soup_top, 10, 0 },
+
+    ConfigField{ "escape", "enabled", &GlifeConfig::escape_enabled, false },
+    ConfigField{ "escape", "check_every", &GlifeConfig::escape_check_every, 30, 1 },
+    ConfigField{ "escape", "remove", &GlifeConfig::escape_remove, false },
+    ConfigField{ "escape", "max_period", &GlifeConfig::escape_max_period, 64, 1 },
+
+    ConfigField{ "checkpoint", "path", &GlifeConfig::checkpoint_path, "glife.ckpt" },
+    ConfigField{ "checkpoint", "every_gen", &GlifeConfig::checkpoint_every_gen, 0, 0 },
+    ConfigField{ "checkpoint", "every_sec", &GlifeConfig::checkpoint_every_sec, 0, 0 },
+
+    ConfigField{ "metrics", "enabled", &GlifeConfig::metrics_enabled, false },
+    ConfigField{ "metrics", "path", &GlifeConfig::metrics_path, "metrics.csv" },
+    ConfigField{ "metrics", "format", &GlifeConfig::metrics_format, "csv", "csv|binary" },
+    ConfigField{ "metrics", "buffer", &GlifeConfig::metrics_buffer, 4096, 2 },
+
+    ConfigField{ "cache", "enabled", &GlifeConfig::cache_enabled, false },
+    ConfigField{ "cache", "path", &GlifeConfig::cache_path, "glife.cache" },
+};
+static_assert(TIP::valid_schema(config_schema), "config_schema has a repeated field or an invalid fall back value");
+
+}  // namespace life
+
+#endif  // _CONFIG_H_
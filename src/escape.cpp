@@ -0,0 +1,107 @@
+/**
+ * EscapeDetector class implementation.
+ *
+ */
+
+#include "escape.h"
+#include "../lib/trace.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace life {
+
+/// Bounding box of a set of cells (inclusive).
+struct Box {
+    int top{INT_MAX}, left{INT_MAX}, bottom{INT_MIN}, right{INT_MIN};
+    void add(const Cell& cell){
+        top = std::min(top, cell.row);
+        bottom = std::max(bottom, cell.row);
+        left = std::min(left, cell.col);
+        right = std::max(right, cell.col);
+    }
+    bool empty(void) const { return top > bottom; }
+};
+
+/// Distance a ship must keep from the core to be considered out of it.
+constexpr int ESCAPE_MARGIN = 2;
+
+const ObjectInfo& EscapeDetector::identify(const std::vector<Cell>& object){
+    // Ships are told apart by their direction, so they are keyed by translation only.
+    auto hash = translated_hash(object);
+    auto it = m_known.find(hash);
+    if(it == m_known.end()){
+        it = m_known.emplace(hash, identify_object(object, m_settings.max_period)).first;
+    }
+    return it->second;
+}
+
+bool EscapeDetector::check(LifeCfg& table, unsigned long gen){
+    if(not m_settings.enabled or m_settings.check_every == 0 or gen % m_settings.check_every != 0){
+        return false;
+    }
+    TRACE_ZONE("EscapeDetector::check");
+
+    // Splits the objects into ships and core.
+    auto objects = split_objects(table.get_alive_cells());
+    std::vector<size_t> ships;
+    std::vector<Cell> core;
+    Box core_box;
+    for(size_t i{0u}; i < objects.size(); i++){
+        const auto& info = identify(objects[i]);
+        if(info.period != 0 and (info.dx != 0 or info.dy != 0)){
+            ships.push_back(i);
+        }
+        else{
+            for(const auto& cell : objects[i]){
+                core.push_back(cell);
+                core_box.add(cell);
+            }
+        }
+    }
+
+    // A ship escapes if it is past a side of the core box and moving away from that side.
+    std::vector<size_t> escaping;
+    for(auto i : ships){
+        Box box;
+        for(const auto& cell : objects[i]) box.add(cell);
+        const auto& info = identify(objects[i]);
+        bool away = core_box.empty()
+            or (box.top > core_box.bottom + ESCAPE_MARGIN and info.dy > 0)
+            or (box.bottom < core_box.top - ESCAPE_MARGIN and info.dy < 0)
+            or (box.left > core_box.right + ESCAPE_MARGIN and info.dx > 0)
+            or (box.right < core_box.left - ESCAPE_MARGIN and info.dx < 0);
+        if(away) escaping.push_back(i);
+    }
+
+    if(m_settings.remove){
+        if(escaping.empty()) return false;
+        // Rebuilds the table without the escaping ships.
+        std::vector<bool> removed(objects.size(), false);
+        for(auto i : escaping) removed[i] = true;
+        std::vector<Cell> remaining;
+        for(size_t i{0u}; i < objects.size(); i++){
+            if(not removed[i]) remaining.insert(remaining.end(), objects[i].begin(), objects[i].end());
+        }
+        std::sort(remaining.begin(), remaining.end(), [](const Cell& a, const Cell& b){
+            return a.row < b.row or (a.row == b.row and a.col < b.col);
+        });
+        table = std::move(remaining);
+        m_ships += escaping.size();
+        return false;
+    }
+
+    // Stops only if every ship is escaping and the core, on its own, is periodic in place.
+    m_ships = escaping.size();
+    if(escaping.empty() or escaping.size() != ships.size()) return false;
+    if(core.empty()){
+        m_core_period = 1;
+        return true;
+    }
+    auto core_info = identify_object(core, m_settings.max_period);
+    if(core_info.period == 0 or core_info.dx != 0 or core_info.dy != 0) return false;
+    m_core_period = core_info.period;
+    return true;
+}
+
+}  // namespace life
@@ -0,0 +1,60 @@
+//! Detection of spaceships escaping from a stable core.
+/*!
+ * @file escape.h
+ *
+ * @details Class EscapeDetector, which periodically splits the table into
+ * objects and finds the spaceships (gliders, *WSS, ...) that are flying
+ * away from the rest of it, so they can be deleted before they hit the
+ * border of the table, or the run can stop once only they are left moving.
+ */
+
+#ifndef _ESCAPE_H_
+#define _ESCAPE_H_
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "census.h"
+#include "life.h"
+
+namespace life {
+
+/// Settings of the escape detection.
+struct EscapeSettings {
+    bool enabled{false};            //!< Whether the detection runs at all.
+    unsigned long check_every{30};  //!< Every how many generations the table is checked.
+    bool remove{false};             //!< Delete the escaping ships, instead of stopping the run.
+    unsigned long max_period{64};   //!< Largest period looked for, in ships and in the core.
+};
+
+/// Finds spaceships leaving the bounding box of the stable core of a table.
+class EscapeDetector {
+   public:
+    /// Creates a detector; `ships` is the number of ships already deleted, when a run is resumed.
+    explicit EscapeDetector(const EscapeSettings& settings, size_t ships = 0) : m_settings{settings}, m_ships{ships} {}
+
+    /// Checks `table`, if it is time to. Returns true if only escaping ships are changing, and the run can stop.
+    /*!
+     * If the settings ask for it, the escaping ships are deleted from `table`
+     * instead, and the run is never stopped.
+     */
+    bool check(LifeCfg& table, unsigned long gen);
+
+    /// Ships found escaping at the last check (or deleted so far, if they are removed).
+    size_t ships(void) const { return m_ships; }
+    /// Period of the core when the run was stopped.
+    unsigned long core_period(void) const { return m_core_period; }
+
+   private:
+    /// Returns what `object` is, identifying each phase and orientation only once.
+    const ObjectInfo& identify(const std::vector<Cell>& object);
+
+    EscapeSettings m_settings;     //!< The settings.
+    std::unordered_map<uint64_t, ObjectInfo> m_known; //!< Objects already identified, by their translated hash.
+    size_t m_ships{0};             //!< See ships().
+    unsigned long m_core_period{0};//!< See core_period().
+};
+
+}  // namespace life
+
+#endif
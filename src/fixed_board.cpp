@@ -0,0 +1,41 @@
+/**
+ * Fixed size boards implementation.
+ *
+ */
+
+#include "fixed_board.h"
+
+namespace life {
+
+/// A specialised size, and its step.
+struct FixedSize {
+    size_t rows, cols;
+    FixedStep step;
+};
+
+/// Sizes with a FixedBoard: the default soup, and those of the smaller patterns in data/.
+constexpr std::array fixed_sizes{
+    FixedSize{ 8, 8, &FixedBoard<8, 8>::step },
+    FixedSize{ 10, 10, &FixedBoard<10, 10>::step },
+    FixedSize{ 12, 40, &FixedBoard<12, 40>::step },
+    FixedSize{ 15, 15, &FixedBoard<15, 15>::step },
+    FixedSize{ 16, 16, &FixedBoard<16, 16>::step },
+    FixedSize{ 20, 20, &FixedBoard<20, 20>::step },
+    FixedSize{ 21, 28, &FixedBoard<21, 28>::step },
+    FixedSize{ 30, 30, &FixedBoard<30, 30>::step },
+    FixedSize{ 32, 32, &FixedBoard<32, 32>::step },
+    FixedSize{ 64, 64, &FixedBoard<64, 64>::step },
+    FixedSize{ 80, 100, &FixedBoard<80, 100>::step },
+    FixedSize{ 100, 100, &FixedBoard<100, 100>::step },
+    FixedSize{ 100, 120, &FixedBoard<100, 120>::step },
+    FixedSize{ 120, 100, &FixedBoard<120, 100>::step },
+};
+
+FixedStep find_fixed_step(size_t rows, size_t cols){
+    for(const auto& size : fixed_sizes){
+        if(size.rows == rows and size.cols == cols) return size.step;
+    }
+    return nullptr;
+}
+
+}  // namespace life
@@ -0,0 +1,100 @@
+//! Stepping of tables whose size is known at compile time.
+/*!
+ * @file fixed_board.h
+ *
+ * @details FixedBoard<Rows, Cols> steps a table of bit-packed rows (the
+ * layout of LifeCfg) with every dimension a compile-time constant: the
+ * generation is copied into a std::array with a frame of dead cells, so
+ * the neighbours are read with no bounds checks, and the loops have fixed
+ * trip counts the compiler can unroll. find_fixed_step() selects, when the
+ * table is created, the specialisation of its size among the common ones;
+ * other sizes keep the dynamic engine (LifeCfg::step_sliced()).
+ */
+
+#ifndef _FIXED_BOARD_H_
+#define _FIXED_BOARD_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace life {
+
+/// Advances rows `top` to `bottom` of a table of bit-packed rows in place, setting the cells born and dead.
+using FixedStep = void (*)(uint64_t* bits, size_t top, size_t bottom, size_t& births, size_t& deaths);
+
+/// A table of `Rows` x `Cols` cells, 64 per word, row by row.
+template <size_t Rows, size_t Cols>
+class FixedBoard {
+   public:
+    static_assert(Rows > 0 and Cols > 0, "A table has at least one cell.");
+    /// Words taken by each row.
+    static constexpr size_t WORDS = (Cols + 63)/64;
+
+    /// Advances rows `top` to `bottom` of `bits` (Rows rows of WORDS words) one generation; the others must stay dead.
+    static void step(uint64_t* bits, size_t top, size_t bottom, size_t& births, size_t& deaths){
+        // The rows around the ones stepped, with a dead row above and below the table and a dead word on each side.
+        std::array<uint64_t, (Rows + 2)*STRIDE> current;
+        const size_t first = top > 0 ? top - 1 : 0, last = bottom + 1 < Rows ? bottom + 1 : Rows - 1;
+        if(top == 0) std::fill_n(current.begin(), STRIDE, 0);
+        if(bottom == Rows - 1) std::fill_n(current.end() - STRIDE, STRIDE, 0);
+        for(size_t row{first}; row <= last; row++){
+            uint64_t* framed = &current[(row + 1)*STRIDE];
+            framed[0] = framed[STRIDE - 1] = 0;
+            for(size_t w{0u}; w < WORDS; w++) framed[w + 1] = bits[row*WORDS + w];
+        }
+
+        size_t born{0}, dead{0};
+        for(size_t row{top}; row <= bottom; row++){
+            const uint64_t* above = &current[row*STRIDE + 1];
+            const uint64_t* middle = above + STRIDE;
+            const uint64_t* below = middle + STRIDE;
+            for(size_t w{0u}; w < WORDS; w++){
+                uint64_t al, a, ar, bl, b, br, cl, c, cr;
+                shifted(above, w, al, a, ar);
+                shifted(middle, w, bl, b, br);
+                shifted(below, w, cl, c, cr);
+                // Neighbour count = ones + 2*(twos_sum + 2*twos_carry + carry), as in LifeCfg::step_sliced().
+                uint64_t top_sum, top_carry, bot_sum, bot_carry, ones, carry, twos_sum, twos_carry;
+                full_add(al, a, ar, top_sum, top_carry);
+                full_add(cl, c, cr, bot_sum, bot_carry);
+                full_add(top_sum, bl ^ br, bot_sum, ones, carry);
+                full_add(top_carry, bl & br, bot_carry, twos_sum, twos_carry);
+                uint64_t next = ~twos_carry & (twos_sum ^ carry) & (ones | b);
+                if(w == WORDS - 1) next &= LAST_MASK;
+                born += __builtin_popcountll(next & ~b);
+                dead += __builtin_popcountll(b & ~next);
+                bits[row*WORDS + w] = next;
+            }
+        }
+        births = born;
+        deaths = dead;
+    }
+
+   private:
+    /// Words of each row of the framed copy.
+    static constexpr size_t STRIDE = WORDS + 2;
+    /// Cells of the last word of a row that are inside the table.
+    static constexpr uint64_t LAST_MASK = Cols%64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (Cols%64)) - 1;
+
+    /// The cells of word `w` of a framed row, with their left and right neighbours lined up.
+    static void shifted(const uint64_t* row, size_t w, uint64_t& left, uint64_t& mid, uint64_t& right){
+        mid = row[w];
+        left = mid << 1 | row[w - 1] >> 63;
+        right = mid >> 1 | row[w + 1] << 63;
+    }
+    /// Adds three bit-sliced values a bit at a time: `sum` gets the low bit of each count and `carry` the high one.
+    static void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry){
+        uint64_t half = a ^ b;
+        sum = half ^ c;
+        carry = (a & b) | (half & c);
+    }
+};
+
+/// Returns FixedBoard<rows, cols>::step if that size is specialised, or nullptr.
+FixedStep find_fixed_step(size_t rows, size_t cols);
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Image encoding implementation.
+ *
+ */
+
+#include "image.h"
+
+#include <algorithm>
+
+#include "../lib/lodepng.h"
+#include "../lib/trace.h"
+
+namespace life {
+
+Frame::Frame(const Canvas& canvas)
+    : pixels(canvas.pixels(), canvas.pixels() + canvas.width()*canvas.height()*canvas.depth()),
+      width{canvas.width()},
+      height{canvas.height()},
+      format{canvas.format()},
+      palette{canvas.palette()}
+{}
+
+/// Deflate settings of each level: window size, nice match length and lazy matching.
+struct DeflateLevel {
+    unsigned windowsize, nicematch, lazymatching;
+};
+constexpr DeflateLevel DEFLATE_LEVELS[10]{
+    {0, 0, 0},   // Stored blocks, no compression.
+    {256, 16, 0}, {512, 32, 0}, {1024, 32, 0}, {1024, 64, 1}, {2048, 64, 1},
+    {2048, 128, 1}, // lodepng's own defaults.
+    {8192, 128, 1}, {16384, 258, 1}, {32768, 258, 1}
+};
+
+/*!
+ * Indexed frames are written with the smallest palette bit depth that
+ * holds their colors, so with two colors each byte of the image covers 8
+ * pixels.
+ */
+bool encode_png(const Frame& frame, int level, std::vector<unsigned char>& out){
+    TRACE_ZONE("encode_png");
+    lodepng::State state;
+    const unsigned char* raw = frame.pixels.data();
+    std::vector<unsigned char> packed;
+    if(frame.format == PixelFormat::INDEXED){
+        const size_t colors = frame.palette.size();
+        const unsigned bits = colors <= 2 ? 1 : colors <= 4 ? 2 : colors <= 16 ? 4 : 8;
+        // The indices are packed here, most significant bits first and with no padding between rows
+        // (lodepng's raw layout), so lodepng can take them as they are instead of converting each pixel.
+        if(bits < 8){
+            const size_t n = frame.width*frame.height, per_byte = 8/bits;
+            packed.assign((n + per_byte - 1)/per_byte, 0);
+            for(size_t i{0u}; i < n; i++){
+                packed[i/per_byte] |= frame.pixels[i] << (8 - bits*(i%per_byte + 1));
+            }
+            raw = packed.data();
+        }
+        for(auto* mode : {&state.info_raw, &state.info_png.color}){
+            mode->colortype = LCT_PALETTE;
+            mode->bitdepth = bits;
+            for(const auto& color : frame.palette){
+                lodepng_palette_add(mode, color.channels[Color::R], color.channels[Color::G], color.channels[Color::B], 255);
+            }
+        }
+    }
+    else{
+        auto type = frame.format == PixelFormat::RGB24 ? LCT_RGB : LCT_RGBA;
+        state.info_raw.colortype = state.info_png.color.colortype = type;
+        state.info_raw.bitdepth = state.info_png.color.bitdepth = 8;
+    }
+    state.encoder.auto_convert = 0;
+
+    const auto& deflate = DEFLATE_LEVELS[std::clamp(level, 0, 9)];
+    auto& zlib = state.encoder.zlibsettings;
+    if(deflate.windowsize == 0){
+        zlib.btype = 0;
+        zlib.use_lz77 = 0;
+    }
+    else{
+        zlib.windowsize = deflate.windowsize;
+        zlib.nicematch = deflate.nicematch;
+        zlib.lazymatching = deflate.lazymatching;
+    }
+
+    out.clear();
+    return lodepng::encode(out, raw, frame.width, frame.height, state) == 0;
+}
+
+bool write_png(const std::string& file, const Frame& frame, int level){
+    std::vector<unsigned char> png;
+    return encode_png(frame, level, png) and lodepng::save_file(png, file) == 0;
+}
+
+/*============================================= ImageWriter =============================================*/
+
+ImageWriter::ImageWriter(size_t n_threads, int level)
+    : m_level{level},
+      m_pool{n_threads}
+{}
+
+ImageWriter::~ImageWriter(){
+    wait();
+}
+
+void ImageWriter::submit(const Canvas& canvas, const std::string& file){
+    // Keeps at most two frames per thread in memory.
+    while(m_pending.size() >= 2*m_pool.size()){
+        if(not m_pending.front().get()) m_failed++;
+        m_pending.pop_front();
+    }
+    auto frame = std::make_shared<Frame>(canvas);
+    m_pending.push_back(m_pool.submit([frame, file, level = m_level]{
+        return write_png(file, *frame, level);
+    }));
+}
+
+size_t ImageWriter::wait(void){
+    while(not m_pending.empty()){
+        if(not m_pending.front().get()) m_failed++;
+        m_pending.pop_front();
+    }
+    return m_failed;
+}
+
+}  // namespace life
@@ -0,0 +1,68 @@
+//! Image encoding of life tables.
+/*!
+ * @file image.h
+ *
+ * @details PNG encoding of a Canvas at a given compression level, with the
+ * smallest palette bit depth that holds its colors (1 bit for the usual two),
+ * and ImageWriter, which encodes the frames of a run on a thread pool so
+ * deflate doesn't hold the simulation back.
+ */
+
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#include <deque>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "../lib/canvas.h"
+#include "thread_pool.h"
+
+namespace life {
+
+/// A copy of the pixels of a Canvas, ready to be encoded on another thread.
+struct Frame {
+    std::vector<Canvas::component_t> pixels; //!< Real pixels, in the storage format.
+    size_t width{0}, height{0};              //!< Real dimensions.
+    PixelFormat format{PixelFormat::INDEXED};//!< How the pixels are stored.
+    std::vector<Color> palette;              //!< Colors of the indices (INDEXED only).
+
+    Frame(void) = default;
+    /// Copies the pixels of `canvas`.
+    explicit Frame(const Canvas& canvas);
+};
+
+/// Encodes `frame` as PNG into `out`. `level` goes from 0 (stored, fastest) to 9 (smallest).
+bool encode_png(const Frame& frame, int level, std::vector<unsigned char>& out);
+/// Encodes `frame` as PNG and writes it to `file`.
+bool write_png(const std::string& file, const Frame& frame, int level);
+
+/// Encodes and writes PNG frames on a thread pool, in parallel across frames.
+/*!
+ * At most two frames per thread wait to be written; past that, submit()
+ * waits for the oldest one, so memory stays bounded when encoding is
+ * slower than the simulation.
+ */
+class ImageWriter {
+   public:
+    /// Uses `n_threads` threads (zero means one per core) and the given PNG level.
+    ImageWriter(size_t n_threads, int level);
+    /// Waits until every frame is written.
+    ~ImageWriter();
+
+    /// Copies the canvas and queues it to be written to `file`.
+    void submit(const Canvas& canvas, const std::string& file);
+    /// Waits until every frame submitted so far is written. Returns how many failed.
+    size_t wait(void);
+
+   private:
+    int m_level;                          //!< PNG compression level.
+    size_t m_failed{0};                   //!< Frames that could not be written.
+    std::deque<std::future<bool>> m_pending; //!< Frames not written yet, oldest first.
+    ThreadPool m_pool;                    //!< Encoding threads (declared last, so it is joined first).
+};
+
+}  // namespace life
+
+#endif
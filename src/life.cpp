@@ -3,20 +3,122 @@
  *
  */
 
+#include <array>
+#include <cmath>  // std::lround().
+
 #include "life.h"
+#include "census.h"
+#include "image.h"
+#include "../lib/trace.h"
 
 namespace life {
 /*============================================= Lifecfg =============================================*/
 
 /// Basic constructor that creates a life board with default dimensions.
 LifeCfg::LifeCfg(const vector<Cell>& input_cell, size_t rows, size_t cols)
+    : LifeCfg(vector<Cell>(input_cell), rows, cols)
+{}
+
+LifeCfg::LifeCfg(vector<Cell>&& input_cell, size_t rows, size_t cols)
 {
-    alive_cells = input_cell;
+    alive_cells = std::move(input_cell);
     r_rows = rows;
     r_cols = cols;
+    words_per_row = (r_cols + 63)/64;
+    fixed_step = find_fixed_step(r_rows, r_cols);
+    pack_cells();
+};
+
+/*!
+ * The bits, the scratch space of step() and the canvas are reused, so a
+ * table whose cells are replaced (ships deleted, say) allocates nothing.
+ */
+LifeCfg& LifeCfg::operator=(std::vector<Cell>&& new_cells){
+    alive_cells = std::move(new_cells);
+    pack_cells();
+    return *this;
+}
+
+void LifeCfg::pack_cells(void){
+    // Packs the alive cells into bits, so each row can be read a word at a time.
+    bits.assign(r_rows*words_per_row, 0);
+    box = BoundingBox{};
+    n_births = n_deaths = 0;
+    for(const auto& cell : alive_cells){
+        if(cell.row >= 0 and cell.col >= 0 and size_t(cell.row) < r_rows and size_t(cell.col) < r_cols){
+            bits[cell.row*words_per_row + cell.col/64] |= uint64_t{1} << (cell.col%64);
+            if(box.empty) box = {size_t(cell.row), size_t(cell.col), size_t(cell.row), size_t(cell.col), false};
+            box.top = std::min(box.top, size_t(cell.row));
+            box.bottom = std::max(box.bottom, size_t(cell.row));
+            box.left = std::min(box.left, size_t(cell.col));
+            box.right = std::max(box.right, size_t(cell.col));
+        }
+    }
+}
+
+/// Returns a unique key for the current alive cells.
+std::string LifeCfg::get_key(void) const {
+    TRACE_ZONE("get_key");
+    std::ostringstream oss;
+    for(const Cell& cell : alive_cells){
+        oss << cell.row << "-" << cell.col << " ";
+    }
+    return oss.str();
+}
+
+/*!
+ * The cells are taken relative to their bounding box, and each of the 8
+ * rotations and reflections of them (apply_symmetry()) is hashed. The hash
+ * of a symmetry is a sum of its mixed cells, so they are compared without
+ * sorting anything. The key is built from the symmetry with the smallest
+ * hash (the first one, on ties), with its cells sorted row by row, so copies of a shape get the
+ * same key wherever they are and however they are turned. Keys are still
+ * exact: different shapes never share one.
+ *
+ * The symmetry is returned along with the position, so that a match can
+ * tell a translated copy (a cycle, moving or not) from a rotated or
+ * reflected one, which isn't: the glider is a reflection of itself after
+ * two generations, but its period is four.
+ */
+std::string LifeCfg::get_canonical_key(Placement& placement) const {
+    TRACE_ZONE("get_canonical_key");
+    placement = Placement{};
+    if(box.empty) return "";
+    const int64_t h = box.bottom - box.top, w = box.right - box.left; // Last row and column of the box.
 
-    // Here, we calculate the neighbours.
+    uint64_t hashes[SYMMETRIES]{};
+    for(const Cell& cell : alive_cells){
+        const int64_t r = cell.row - int64_t(box.top), c = cell.col - int64_t(box.left);
+        for(int symmetry{0}; symmetry < SYMMETRIES; symmetry++){
+            auto [tr, tc] = apply_symmetry(symmetry, r, c, h, w);
+            hashes[symmetry] += mix64(uint64_t(tr) << 32 | uint64_t(tc));
+        }
+    }
+    const int best = std::min_element(hashes, hashes + SYMMETRIES) - hashes;
+
+    std::vector<std::pair<int64_t, int64_t>> cells;
+    cells.reserve(alive_cells.size());
+    for(const Cell& cell : alive_cells){
+        cells.push_back(apply_symmetry(best, cell.row - int64_t(box.top), cell.col - int64_t(box.left), h, w));
+    }
+    // The cells are already row by row without a symmetry.
+    if(best != 0) std::sort(cells.begin(), cells.end());
+
+    std::string key;
+    key.reserve(cells.size()*8);
+    for(const auto& [r, c] : cells){
+        key += std::to_string(r);
+        key += '-';
+        key += std::to_string(c);
+        key += ' ';
+    }
+    placement = Placement{uint8_t(best), long(box.top), long(box.left)};
+    return key;
+}
 
+/// Returns all the neighbours of the current alive cells. The map is built on each call.
+std::unordered_map<std::string, unsigned> LifeCfg::get_neighbours() const {
+    std::unordered_map<std::string, unsigned> neighbours;
     for(const auto& cell : alive_cells){
         std::string topLeft_key = cell.row > 0 and cell.col > 0 ? std::to_string(cell.row-1) + "-" + std::to_string(cell.col-1) : "";
         std::string top_key = cell.row > 0 ? std::to_string(cell.row-1) + "-" + std::to_string(cell.col) : "";
@@ -42,52 +144,38 @@ LifeCfg::LifeCfg(const vector<Cell>& input_cell, size_t rows, size_t cols)
         }
 
     }
-};
-
-/// Returns a unique key for the current alive cells.
-std::string LifeCfg::get_key(void) const {
-    std::ostringstream oss;
-    for(const Cell& cell : alive_cells){
-        oss << cell.row << "-" << cell.col << " ";
-    }
-    return oss.str();
-}
-
-/// Returns all the neighbours of the current alive cells.
-std::unordered_map<std::string, unsigned> LifeCfg::get_neighbours() const {
     return neighbours;
 }
 
 /// Returns true if the cell is alive.
-bool LifeCfg::is_alive(const Cell& cell){
-    for(const auto& other : alive_cells){
-        if(other.row == cell.row && other.col == cell.col){
-            return true;
-        }
+bool LifeCfg::is_alive(const Cell& cell) const {
+    if(cell.row < 0 or cell.col < 0 or size_t(cell.row) >= r_rows or size_t(cell.col) >= r_cols){
+        return false;
     }
-    return false;
+    return (row_word(cell.row, cell.col) >> (cell.col%64)) & 1;
 };
 
 /// A generalization of is_alive. Returns true if the cell is in the given vector.
-bool isInVector(std::vector<life::Cell> next_gen, life::Cell cell){
+bool isInVector(const std::vector<life::Cell>& next_gen, const life::Cell& cell){
     for(const auto& other : next_gen){
         if(other.row == cell.row && other.col == cell.col){
             return true;
         }
-        return false;
     }
+    return false;
 }
 
 /// Sorts a vector<Cell>.
-bool sort_cells(life::Cell first, life::Cell last){
+bool sort_cells(const life::Cell& first, const life::Cell& last){
     return first.row < last.row or (first.row == last.row and first.col <= last.col);
 }
 
 /// Returns the next generation as a vector of cells.
 std::vector<Cell> LifeCfg::get_next_gen(){
+    TRACE_ZONE("get_next_gen");
     std::vector<Cell> next_gen;
 
-    for(const auto& cell_inst : neighbours){
+    for(const auto& cell_inst : get_neighbours()){
         int divisor = cell_inst.first.find("-");
         int quantity = cell_inst.second;
         int row = std::stoi(cell_inst.first.substr(0, divisor));
@@ -119,62 +207,452 @@ std::vector<Cell> LifeCfg::get_next_gen(){
     return next_gen;
 }
 
-std::vector<Cell> LifeCfg::get_alive_cells(void) const {
-    return alive_cells;
+/// Adds three bit-sliced values a bit at a time: `sum` gets the low bit of each count and `carry` the high one.
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry){
+    uint64_t half = a ^ b;
+    sum = half ^ c;
+    carry = (a & b) | (half & c);
 }
 
-/// Prints the current life table.
-void LifeCfg::print_life(char alive_char){
-    for(int i{0u}; i < r_rows; i++){
-        for(int j{0u}; j < r_cols; j++){
-            Cell current_cell(i, j);
-            if(is_alive(current_cell)){
-                std::cout << alive_char;
+/*!
+ * Tables of a size with a FixedBoard are stepped by it over the rows of
+ * the bounding box and one on each side, across their whole width; small
+ * tables gain more from the fixed loops than they lose computing the dead
+ * columns. Other sizes go to step_sliced().
+ */
+void LifeCfg::step(void){
+    if(fixed_step == nullptr){
+        step_sliced();
+        return;
+    }
+    TRACE_ZONE("step_fixed");
+    if(box.empty) return;
+    size_t top = box.top > 0 ? box.top-1 : 0;
+    size_t bottom = std::min(box.bottom+1, r_rows-1);
+    fixed_step(bits.data(), top, bottom, n_births, n_deaths);
+    collect_cells(top, bottom, 0, words_per_row-1);
+}
+
+/*!
+ * Each word holds 64 cells, and the 8 neighbours of all of them are counted
+ * at once with bitwise adders. Since cells can only be born next to alive
+ * ones, only the bounding box grown by one cell in each direction is
+ * computed; everything else stays dead.
+ */
+void LifeCfg::step_sliced(void){
+    TRACE_ZONE("step");
+    if(box.empty) return;
+    size_t top = box.top > 0 ? box.top-1 : 0;
+    size_t bottom = std::min(box.bottom+1, r_rows-1);
+    size_t first_word = (box.left > 0 ? box.left-1 : 0)/64;
+    size_t last_word = std::min(box.right+1, r_cols-1)/64;
+    size_t span = last_word - first_word + 1;
+    next_bits.resize((bottom - top + 1)*span);
+
+    // Word `w` of `row`, with zeros outside the table.
+    auto word = [&](size_t row, size_t w)->uint64_t {
+        return row < r_rows and w < words_per_row ? bits[row*words_per_row + w] : 0;
+    };
+    // The cells of a row, with their left and right neighbours lined up.
+    auto shifted = [&](size_t row, size_t w, uint64_t& left, uint64_t& mid, uint64_t& right){
+        mid = word(row, w);
+        left = mid << 1 | (w > 0 ? word(row, w-1) >> 63 : 0);
+        right = mid >> 1 | word(row, w+1) << 63;
+    };
+    // Cells past the last column of the table must stay dead.
+    const uint64_t last_mask = r_cols%64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (r_cols%64)) - 1;
+
+    for(size_t row{top}; row <= bottom; row++){
+        for(size_t w{first_word}; w <= last_word; w++){
+            uint64_t al, a, ar, bl, b, br, cl, c, cr;
+            shifted(row-1, w, al, a, ar); // row-1 wraps to a huge value on the first row, which reads zeros.
+            shifted(row, w, bl, b, br);
+            shifted(row+1, w, cl, c, cr);
+            // Neighbour count = ones + 2*(twos_sum + 2*twos_carry + carry).
+            uint64_t top_sum, top_carry, bot_sum, bot_carry, ones, carry, twos_sum, twos_carry;
+            full_add(al, a, ar, top_sum, top_carry);
+            full_add(cl, c, cr, bot_sum, bot_carry);
+            full_add(top_sum, bl ^ br, bot_sum, ones, carry);
+            full_add(top_carry, bl & br, bot_carry, twos_sum, twos_carry);
+            // Exactly one pair: counts of 2 or 3. Alive cells survive with either; dead ones are born with 3.
+            uint64_t one_pair = ~twos_carry & (twos_sum ^ carry);
+            uint64_t next = one_pair & (ones | b);
+            if(w == words_per_row-1) next &= last_mask;
+            next_bits[(row-top)*span + w-first_word] = next;
+        }
+    }
+    commit_next(top, bottom, first_word, last_word);
+}
+
+/// Builds the next state of the cell in the middle of every 3x3 neighbourhood (bit r*3+c holds row r, column c).
+static constexpr std::array<bool, 512> make_cell_lut(){
+    std::array<bool, 512> lut{};
+    for(unsigned neighbourhood{0u}; neighbourhood < 512; neighbourhood++){
+        unsigned alive{0};
+        for(unsigned i{0u}; i < 9; i++) alive += (neighbourhood >> i) & 1;
+        bool center = (neighbourhood >> 4) & 1;
+        lut[neighbourhood] = alive == 3 or (center and alive == 4);  // Counts include the center.
+    }
+    return lut;
+}
+
+/// Builds the table of step_lut(): for each 4x4 tile (bit r*4+c holds row r, column c), the next state of its central 2x2 cells (bit r*2+c).
+static constexpr std::array<uint8_t, 65536> make_tile_lut(){
+    constexpr std::array<bool, 512> cell_lut = make_cell_lut();
+    // The 3x3 neighbourhood of the cell at row r, column c of the tile, for r and c 1 or 2.
+    auto neighbourhood = [](unsigned tile, unsigned r, unsigned c){
+        unsigned shift = (r-1)*4 + c-1;
+        return (tile >> shift & 7) | (tile >> (shift + 4) & 7) << 3 | (tile >> (shift + 8) & 7) << 6;
+    };
+    std::array<uint8_t, 65536> lut{};
+    for(unsigned tile{0u}; tile < 65536; tile++){
+        lut[tile] = cell_lut[neighbourhood(tile, 1, 1)] | cell_lut[neighbourhood(tile, 1, 2)] << 1
+                    | cell_lut[neighbourhood(tile, 2, 1)] << 2 | cell_lut[neighbourhood(tile, 2, 2)] << 3;
+    }
+    return lut;
+}
+
+/// Next state of the central 2x2 cells of every 4x4 tile, worked out by the compiler.
+static constexpr std::array<uint8_t, 65536> TILE_LUT = make_tile_lut();
+
+/*!
+ * The same region as step_sliced() is computed, two rows and two columns at a
+ * time: the 4x4 tile around each 2x2 block is gathered from four rows of
+ * bits and looked up in TILE_LUT. The table takes 64 KB, more than most
+ * L1 caches hold; benchmark mode measures what that costs against step_sliced().
+ */
+void LifeCfg::step_lut(void){
+    TRACE_ZONE("step_lut");
+    if(box.empty) return;
+    size_t top = box.top > 0 ? box.top-1 : 0;
+    size_t bottom = std::min(box.bottom+1, r_rows-1);
+    size_t first_word = (box.left > 0 ? box.left-1 : 0)/64;
+    size_t last_word = std::min(box.right+1, r_cols-1)/64;
+    size_t span = last_word - first_word + 1;
+    next_bits.resize((bottom - top + 1)*span);
+
+    // Word `w` of `row`, with zeros outside the table.
+    auto word = [&](size_t row, size_t w)->uint64_t {
+        return row < r_rows and w < words_per_row ? bits[row*words_per_row + w] : 0;
+    };
+    const uint64_t last_mask = r_cols%64 == 0 ? ~uint64_t{0} : (uint64_t{1} << (r_cols%64)) - 1;
+
+    for(size_t row{top}; row <= bottom; row += 2){
+        const bool pair = row + 1 <= bottom; // An odd number of rows leaves a last block of one row.
+        for(size_t w{first_word}; w <= last_word; w++){
+            // For each of the 4 rows of the tiles: the word, and the word moved one column right, so bit k is column k-1.
+            uint64_t mid[4], shifted[4], right[4];
+            for(size_t i{0u}; i < 4; i++){
+                size_t r = row + i - 1; // Wraps to a huge value above the first row, which reads zeros.
+                mid[i] = word(r, w);
+                shifted[i] = mid[i] << 1 | (w > 0 ? word(r, w-1) >> 63 : 0);
+                right[i] = word(r, w+1) & 1;
             }
-            else{
-                std::cout << ".";
+            uint64_t upper{0}, lower{0};
+            for(unsigned c{0u}; c < 64; c += 2){
+                unsigned tile{0};
+                for(size_t i{0u}; i < 4; i++){
+                    uint64_t bits4 = c < 62 ? shifted[i] >> c : shifted[i] >> 62 | (mid[i] >> 63) << 2 | right[i] << 3;
+                    tile |= unsigned(bits4 & 15) << (i*4);
+                }
+                uint64_t next = TILE_LUT[tile];
+                upper |= (next & 3) << c;
+                lower |= (next >> 2) << c;
+            }
+            if(w == words_per_row-1){
+                upper &= last_mask;
+                lower &= last_mask;
+            }
+            next_bits[(row-top)*span + w-first_word] = upper;
+            if(pair) next_bits[(row+1-top)*span + w-first_word] = lower;
+        }
+    }
+    commit_next(top, bottom, first_word, last_word);
+}
+
+/// Replaces the given rows and words of `bits` with `next_bits`, counting births and deaths.
+void LifeCfg::commit_next(size_t top, size_t bottom, size_t first_word, size_t last_word){
+    const size_t span = last_word - first_word + 1;
+    n_births = n_deaths = 0;
+    for(size_t row{top}; row <= bottom; row++){
+        auto* current = &bits[row*words_per_row + first_word];
+        const auto* next = &next_bits[(row-top)*span];
+        for(size_t w{0u}; w < span; w++){
+            n_births += __builtin_popcountll(next[w] & ~current[w]);
+            n_deaths += __builtin_popcountll(current[w] & ~next[w]);
+            current[w] = next[w];
+        }
+    }
+    collect_cells(top, bottom, first_word, last_word);
+}
+
+void LifeCfg::collect_cells(size_t top, size_t bottom, size_t first_word, size_t last_word){
+    alive_cells.clear();
+    box = BoundingBox{};
+    for(size_t row{top}; row <= bottom; row++){
+        for(size_t w{first_word}; w <= last_word; w++){
+            for(uint64_t word = bits[row*words_per_row + w]; word != 0; word &= word - 1){
+                size_t col = w*64 + __builtin_ctzll(word);
+                alive_cells.push_back({int(row), int(col)});
+                if(box.empty) box = {row, col, row, col, false};
+                box.bottom = row;
+                box.left = std::min(box.left, col);
+                box.right = std::max(box.right, col);
             }
         }
-        std::cout << '\n';
     }
 }
 
+/// Returns the 256 braille glyphs, indexed by four 2-bit row slices (top row in the lowest bits).
+static const std::vector<std::string>& braille_glyphs(){
+    static const std::vector<std::string> glyphs = []{
+        // Braille dot bit for each (row, column) of a 2x4 glyph.
+        constexpr unsigned dots[4][2]{ {0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80} };
+        std::vector<std::string> table(256);
+        for(unsigned idx{0u}; idx < 256; idx++){
+            unsigned mask{0u};
+            for(unsigned r{0u}; r < 4; r++){
+                if(idx >> (2*r) & 1) mask |= dots[r][0];
+                if(idx >> (2*r+1) & 1) mask |= dots[r][1];
+            }
+            // UTF-8 encoding of U+2800 + mask.
+            table[idx] = { char(0xE2), char(0xA0 | (mask >> 6)), char(0x80 | (mask & 0x3F)) };
+        }
+        return table;
+    }();
+    return glyphs;
+}
+
+/// Renders the current life table. Only the cells inside the bounding box are looked at.
+void LifeCfg::render_text(std::string& out, char alive_char, TextStyle style) const {
+    TRACE_ZONE("render_text");
+    // Rows (or columns) of glyphs covering the bounding box.
+    auto inside = [&](size_t first, size_t last, size_t start, size_t cells){
+        return not box.empty and start + cells > first and start <= last;
+    };
+    std::string line;
+    if(style == TextStyle::ASCII){
+        const std::string blank(r_cols, '.');
+        for(size_t i{0u}; i < r_rows; i++){
+            if(not inside(box.top, box.bottom, i, 1)){
+                out += blank;
+                out += '\n';
+                continue;
+            }
+            line = blank;
+            for(size_t j{box.left}; j <= box.right; j++){
+                if((row_word(i, j) >> (j%64)) & 1) line[j] = alive_char;
+            }
+            out += line;
+            out += '\n';
+        }
+    }
+    else if(style == TextStyle::HALFBLOCK){
+        // Index: top cell in bit 0, bottom cell in bit 1.
+        static const char* glyphs[4]{ " ", "\u2580", "\u2584", "\u2588" };
+        const std::string blank(r_cols, ' ');
+        for(size_t i{0u}; i < r_rows; i += 2){
+            if(not inside(box.top, box.bottom, i, 2)){
+                out += blank;
+                out += '\n';
+                continue;
+            }
+            line.assign(box.left, ' ');
+            for(size_t j{box.left}; j <= box.right; j++){
+                auto top = (row_word(i, j) >> (j%64)) & 1;
+                auto bot = (row_word(i+1, j) >> (j%64)) & 1;
+                line += glyphs[top | bot << 1];
+            }
+            line.append(r_cols - box.right - 1, ' ');
+            out += line;
+            out += '\n';
+        }
+    }
+    else{
+        const auto& glyphs = braille_glyphs();
+        const size_t width = (r_cols + 1)/2;
+        std::string blank;
+        for(size_t j{0u}; j < width; j++) blank += glyphs[0];
+        for(size_t i{0u}; i < r_rows; i += 4){
+            if(not inside(box.top, box.bottom, i, 4)){
+                out += blank;
+                out += '\n';
+                continue;
+            }
+            line.clear();
+            // Columns are taken in pairs; since 64 is even, a pair never crosses a word.
+            for(size_t j{0u}; j < r_cols; j += 2){
+                size_t idx{0u};
+                if(inside(box.left, box.right, j, 2)){
+                    for(size_t r{0u}; r < 4; r++){
+                        idx |= ((row_word(i+r, j) >> (j%64)) & 3) << (2*r);
+                    }
+                }
+                line += glyphs[idx];
+            }
+            out += line;
+            out += '\n';
+        }
+    }
+}
+
+/// Prints the current life table.
+void LifeCfg::print_life(char alive_char, TextStyle style){
+    std::string out;
+    render_text(out, alive_char, style);
+    std::cout << out;
+}
+
 bool LifeCfg::is_empty(){
     return alive_cells.size() == 0;
 }
 
-void LifeCfg::set_life_canvas(short block_size, Color bg_color, Color alive){
-    life_table = Canvas(r_cols, r_rows, block_size);
-    life_table.clear(bg_color);
+/*!
+ * The canvas is kept between generations. The rows of the cells are
+ * rasterised straight from `bits`, and only inside the bounding box of
+ * this generation joined with the one drawn on the last, since everything
+ * else is background already. Views of part of the table, or reduced ones,
+ * are drawn by draw_view().
+ */
+void LifeCfg::set_life_canvas(short block_size, Color bg_color, Color alive, const ImageView& view){
+    TRACE_ZONE("set_life_canvas");
+    if(not view.whole(r_rows, r_cols)){
+        draw_view(block_size, bg_color, alive, view);
+        return;
+    }
+    if(life_table.width() != r_cols*block_size or life_table.height() != r_rows*block_size
+       or life_table.block_size() != size_t(block_size) or not (canvas_bg == bg_color)){
+        // Two colors only: background and alive cells are stored as indices 0 and 1.
+        life_table = Canvas(r_cols, r_rows, block_size, PixelFormat::INDEXED);
+        life_table.set_palette({bg_color, alive});
+        life_table.clear(bg_color);
+        canvas_bg = bg_color;
+        canvas_box = BoundingBox{};
+    }
+    // Only a new alive color changes the palette; setting it on every generation would allocate each time.
+    const auto& palette = life_table.palette();
+    if(palette.size() != 2 or not (palette[0] == bg_color) or not (palette[1] == alive)){
+        life_table.set_palette({bg_color, alive});
+    }
 
-    for(const auto& cell : alive_cells){
-        life_table.pixel(cell.col, cell.row, alive);
+    BoundingBox region = canvas_box.empty ? box : canvas_box;
+    if(not box.empty){
+        region.top = std::min(region.top, box.top);
+        region.bottom = std::max(region.bottom, box.bottom);
+        region.left = std::min(region.left, box.left);
+        region.right = std::max(region.right, box.right);
+    }
+    if(not region.empty){
+        for(size_t row{region.top}; row <= region.bottom; row++){
+            life_table.draw_bits(row, &bits[row*words_per_row], region.left, region.right, bg_color, alive);
+        }
     }
+    canvas_box = box;
 }
 
-/// Splits the input string based on `delimiter` into a list of substrings.
-std::vector<std::string> split(const std::string & input_str, char delimiter='.'){
+ImageView ImageView::clamp(size_t rows, size_t cols) const {
+    ImageView view;
+    view.x = std::min(x, cols);
+    view.y = std::min(y, rows);
+    view.width = std::min(width ? width : cols, cols - view.x);
+    view.height = std::min(height ? height : rows, rows - view.y);
+    view.scale = std::max<size_t>(scale, 1);
+    return view;
+}
+
+std::vector<Color> ImageView::palette(Color bg_color, Color alive) const {
+    std::vector<Color> colors(shades() + 1);
+    for(size_t i{0u}; i < colors.size(); i++){
+        for(int c{0}; c < 3; c++){
+            int from = bg_color.channels[c], to = alive.channels[c];
+            colors[i].channels[c] = Color::color_t(from + std::lround(double(to - from)*i/shades()));
+        }
+    }
+    return colors;
+}
+
+/*!
+ * A pixel stands for a block of scale x scale cells (smaller at the right
+ * and bottom edges of the view) and gets one of up to 256 shades between
+ * the background and the alive color, by the fraction of its cells that
+ * are alive. Any alive cell makes it at least the first shade, so sparse
+ * patterns stay visible.
+ *
+ * Only the alive cells of the rows of the pixel row are visited, so the
+ * work follows the size of the image and the population, not the size the
+ * table would have at one cell per pixel.
+ */
+void LifeCfg::shade_row(const ImageView& view, size_t y, std::vector<uint32_t>& counts, Canvas::component_t* out) const {
+    const size_t x = view.x, w = view.width, scale = view.scale, shades = view.shades();
+    const size_t first_row = view.y + y*scale, last_row = std::min(first_row + scale, view.y + view.height);
+    counts.assign(view.pixel_cols(), 0);
+    for(size_t row{first_row}; row < last_row; row++){
+        if(box.empty or row < box.top or row > box.bottom or w == 0) continue;
+        for(size_t word{x/64}; word <= (x + w - 1)/64; word++){
+            uint64_t cells = bits[row*words_per_row + word];
+            // Drops the columns outside the view.
+            if(word == x/64) cells &= ~uint64_t(0) << (x%64);
+            if(word == (x + w - 1)/64 and (x + w)%64) cells &= ~(~uint64_t(0) << ((x + w)%64));
+            for(; cells; cells &= cells - 1){
+                counts[(word*64 + __builtin_ctzll(cells) - x)/scale]++;
+            }
+        }
+    }
+    const size_t block_rows = last_row - first_row;
+    for(size_t col{0u}; col < counts.size(); col++){
+        const size_t area = block_rows*(std::min(col*scale + scale, w) - col*scale);
+        out[col] = Canvas::component_t((counts[col]*shades + area - 1)/area);
+    }
+}
+
+/// The canvas is sized by the view, and each of its rows is drawn once, from shade_row().
+void LifeCfg::draw_view(short block_size, Color bg_color, Color alive, const ImageView& view){
+    const ImageView clamped = view.clamp(r_rows, r_cols);
+    const size_t out_w = clamped.pixel_cols(), out_h = clamped.pixel_rows();
+    if(life_table.width() != out_w*block_size or life_table.height() != out_h*block_size
+       or life_table.block_size() != size_t(block_size)){
+        life_table = Canvas(out_w, out_h, block_size, PixelFormat::INDEXED);
+    }
+    life_table.set_palette(clamped.palette(bg_color, alive));
+    canvas_bg = bg_color;
+    canvas_box = BoundingBox{0, 0, out_h ? out_h - 1 : 0, out_w ? out_w - 1 : 0, out_h == 0 or out_w == 0};
+
+    view_row.resize(out_w);
+    for(size_t out_y{0u}; out_y < out_h; out_y++){
+        shade_row(clamped, out_y, view_counts, view_row.data());
+        life_table.draw_indices(out_y, view_row.data());
+    }
+}
+
+/// Splits the input string based on `delimiter` into a list of substrings, skipping the blanks that start each one.
+std::vector<std::string> split(std::string_view input_str, char delimiter='.'){
     // Store the tokens.
     std::vector<std::string> tokens;
-    // read tokens from a string buffer.
-    std::istringstream iss;
-    iss.str(input_str);
-    // This will hold a single token temporarily.
-    std::string token;
-    while (std::getline(iss >> std::ws, token, delimiter))
-        tokens.emplace_back(token);
+    size_t start{0};
+    while(true){
+        while(start < input_str.size() and std::isspace(static_cast<unsigned char>(input_str[start]))) start++;
+        if(start >= input_str.size()) break;
+        size_t end = std::min(input_str.find(delimiter, start), input_str.size());
+        tokens.emplace_back(input_str.substr(start, end - start));
+        start = end + 1;
+    }
     return tokens;
 }
 
-bool LifeCfg::save_img(std::string path, std::string file_name){
+/// Returns the file `file_name` in `path`, with its extension (if any) replaced by `extension`.
+static std::string file_in(std::string_view path, std::string_view file_name, std::string_view extension){
+    std::string file{path};
     // Adds / to the end of the path if there is none.
-    if(path[path.length()-1] != '/') path += '/';
-
-    // Makes sure the file_name ends with .ppm.
+    if(not file.empty() and file.back() != '/') file += '/';
     auto components = split(file_name, '.');
-    file_name = components[0] + ".ppm";
+    if(not components.empty()) file += components[0];
+    file += extension;
+    return file;
+}
 
-    std::ofstream ofs_file(path+file_name, std::ios::out);
+bool LifeCfg::save_img(std::string_view path, std::string_view file_name){
+    TRACE_ZONE("save_img");
+    std::ofstream ofs_file(file_in(path, file_name, ".ppm"), std::ios::out);
     if (not ofs_file.is_open())
         return false;
 
@@ -183,14 +661,28 @@ bool LifeCfg::save_img(std::string path, std::string file_name){
     ofs_file << std::to_string(life_table.width()) + " " + std::to_string(life_table.height()) << '\n';
     ofs_file << 255 << "\n\n";
 
-    // Data of the canvas.
+    // Data of the canvas, as palette indices; each color is only formatted once.
     auto data = life_table.pixels();
+    const size_t width = life_table.width(), block = life_table.block_size();
+    std::vector<std::string> colors;
+    for(const auto& color : life_table.palette()){
+        colors.push_back(std::to_string(color.channels[Color::R]) + " " + std::to_string(color.channels[Color::G]) + " "
+                         + std::to_string(color.channels[Color::B]) + "\n");
+    }
+
+    // Rows outside the drawn bounding box are all background, so they are written as a single string.
+    std::string blank, line;
+    for(size_t x{0u}; x < width; x++) blank += colors[0];
 
     // Writing canvas data into the ppm file
-    for(long i{0u}; i < life_table.width()*life_table.height()*4; i += 4){
-        ofs_file << (int)data[i] << " ";
-        ofs_file << (int)data[i+1] << " ";
-        ofs_file << (int)data[i+2] << "\n";
+    for(size_t y{0u}; y < life_table.height(); y++){
+        if(canvas_box.empty or y/block < canvas_box.top or y/block > canvas_box.bottom){
+            ofs_file << blank;
+            continue;
+        }
+        line.clear();
+        for(size_t x{0u}; x < width; x++) line += colors[data[y*width + x]];
+        ofs_file << line;
     }
     
     ofs_file.close();
@@ -198,20 +690,215 @@ bool LifeCfg::save_img(std::string path, std::string file_name){
     return true; 
 }
 
+bool LifeCfg::save_png(std::string_view path, std::string_view file_name, int level){
+    TRACE_ZONE("save_png");
+    return write_png(file_in(path, file_name, ".png"), Frame{life_table}, level);
+}
+
+bool LifeCfg::save_rle(std::string_view path, std::string_view file_name) const {
+    TRACE_ZONE("save_rle");
+    std::ofstream ofs_file(file_in(path, file_name, ".rle"), std::ios::out);
+    if (not ofs_file.is_open())
+        return false;
+
+    auto components = split(file_name, '.');
+    ofs_file << "#N " << (components.empty() ? "" : components[0]) << '\n';
+    ofs_file << "x = " << r_cols << ", y = " << r_rows << ", rule = B3/S23" << '\n';
+
+    // Runs are written as <count><tag>, where the count is omitted when it is 1.
+    std::string line;
+    auto emit = [&](size_t count, char tag){
+        std::string item = (count > 1 ? std::to_string(count) : "") + tag;
+        if(line.length() + item.length() > 70){ // RLE lines should not exceed 70 characters.
+            ofs_file << line << '\n';
+            line.clear();
+        }
+        line += item;
+    };
+
+    size_t pending_rows{0}; // Row ends not written yet, so empty rows can be merged.
+    for(size_t i{0u}; i < r_rows; i++){
+        size_t j{0u};
+        while(j < r_cols){
+            bool alive = (row_word(i, j) >> (j%64)) & 1;
+            size_t run{1u};
+            while(j+run < r_cols and bool((row_word(i, j+run) >> ((j+run)%64)) & 1) == alive) run++;
+            // Trailing dead cells are implicit.
+            if(alive or j+run < r_cols){
+                if(pending_rows > 0){
+                    emit(pending_rows, '$');
+                    pending_rows = 0;
+                }
+                emit(run, alive ? 'o' : 'b');
+            }
+            j += run;
+        }
+        pending_rows++;
+    }
+    line += '!';
+    ofs_file << line << '\n';
+    ofs_file.close();
+
+    return true;
+}
+
+/*============================================= Pattern =============================================*/
+
+/// Reads a RLE file: `#` comment lines, a `x = cols, y = rows` header and `<count><tag>` runs.
+static bool load_rle(std::ifstream& input, Pattern& pattern){
+    std::string line;
+    // Looking for the header.
+    while(std::getline(input, line) and (line.empty() or line[0] == '#'));
+    auto x_idx = line.find('x');
+    auto y_idx = line.find('y');
+    if(x_idx == std::string::npos or y_idx == std::string::npos) return false;
+    try {
+        pattern.cols = std::stoul(line.substr(line.find('=', x_idx)+1));
+        pattern.rows = std::stoul(line.substr(line.find('=', y_idx)+1));
+    }
+    catch(...){ return false; }
+    pattern.alive_char = '*';
+
+    int row{0}, col{0};
+    size_t count{0};
+    char tag;
+    while(input.get(tag) and tag != '!'){
+        if(std::isdigit(static_cast<unsigned char>(tag))){
+            count = count*10 + (tag - '0');
+            continue;
+        }
+        if(count == 0) count = 1;
+        if(tag == '$'){
+            row += count;
+            col = 0;
+        }
+        else if(tag == 'b'){
+            col += count;
+        }
+        else if(not std::isspace(static_cast<unsigned char>(tag))){ // Any other tag is an alive cell.
+            for(size_t k{0u}; k < count; k++){
+                if(size_t(row) < pattern.rows and size_t(col) < pattern.cols) pattern.cells.push_back({row, col});
+                col++;
+            }
+        }
+        count = 0;
+    }
+    return true;
+}
+
+/// Reads a .dat file: a `rows cols` line, a line with the alive character and then the table itself.
+static bool load_dat(std::ifstream& input, Pattern& pattern){
+    std::string line;
+
+    // Getting rows and columns
+    std::getline(input, line);
+    size_t space_idx = line.find(" ");
+    try {
+        pattern.rows = std::stoul(line.substr(0, space_idx));
+        pattern.cols = std::stoul(line.substr(space_idx+1, line.length()));
+    }
+    catch(...){ return false; }
+
+    // Getting character that represents alive cell.
+    std::getline(input, line);
+    pattern.alive_char = line.empty() ? '*' : line[0];
+
+    // Getting positions of living cells.
+    int current_row = 0;
+    while(std::getline(input, line) and size_t(current_row) < pattern.rows){
+        for(size_t column{0u}; column < pattern.cols and column < line.length(); column++){
+            if(line[column] == pattern.alive_char){
+                pattern.cells.push_back({current_row, int(column)});
+            }
+        }
+
+        current_row++;
+    }
+    return true;
+}
+
+bool parse_viewport(const std::string& text, ImageView& view){
+    std::istringstream in{text};
+    size_t values[4];
+    char comma;
+    for(int i{0}; i < 4; i++){
+        if(i > 0 and not (in >> comma and comma == ',')) return false;
+        if(in >> std::ws and in.peek() == '-') return false;
+        if(not (in >> values[i])) return false;
+    }
+    if(not (in >> std::ws).eof() or values[2] == 0 or values[3] == 0) return false;
+    view.x = values[0];
+    view.y = values[1];
+    view.width = values[2];
+    view.height = values[3];
+    return true;
+}
+
+bool parse_scale(const std::string& text, ImageView& view){
+    std::istringstream in{text};
+    size_t n;
+    char slash;
+    if(in >> std::ws and in.peek() == '-') return false;
+    if(not (in >> n)) return false;
+    // "1/N" reads as 1, then the denominator; a lone number can only be 1.
+    if(n != 1) return false;
+    if(not (in >> std::ws).eof()){
+        if(not (in >> slash and slash == '/') or (in >> std::ws).peek() == '-' or not (in >> n)) return false;
+    }
+    if(not (in >> std::ws).eof() or n == 0) return false;
+    view.scale = n;
+    return true;
+}
+
+bool load_pattern(const std::string& file_name, Pattern& pattern){
+    TRACE_ZONE("load_pattern");
+    std::ifstream input{file_name};
+    if(not input.is_open()) return false;
+
+    pattern = Pattern{};
+    auto extension = file_name.substr(std::min(file_name.length(), file_name.rfind('.')+1));
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == "rle" ? load_rle(input, pattern) : load_dat(input, pattern);
+}
+
 /*============================================= SimDatabase =============================================*/
 
-SimDatabase::SimDatabase(){/* empty */};
+SimDatabase::SimDatabase(bool canonical) : m_canonical{canonical} {/* empty */};
+
+std::string SimDatabase::key(const LifeCfg& table, Placement& placement) const {
+    placement = Placement{};
+    return m_canonical ? table.get_canonical_key(placement) : table.get_key();
+}
 
 bool SimDatabase::find(const std::string& key) const {
+    TRACE_ZONE("SimDatabase::find");
     return generations.count(key) != 0;
 }
 
-void SimDatabase::insert(const std::string& key, unsigned long value){
-    generations.insert({key, value});
+/// Records of other symmetries are copies of the shape turned around, not repetitions of it.
+const SimDatabase::Record* SimDatabase::find(const std::string& key, const Placement& placement) const {
+    TRACE_ZONE("SimDatabase::find");
+    auto [first, last] = generations.equal_range(key);
+    for(auto it = first; it != last; ++it){
+        if(it->second.placement.symmetry == placement.symmetry) return &it->second;
+    }
+    return nullptr;
+}
+
+/// Keeps the first generation of each key and symmetry.
+void SimDatabase::insert(const std::string& key, unsigned long value, const Placement& placement){
+    TRACE_ZONE("SimDatabase::insert");
+    if(find(key, placement) == nullptr) generations.insert({key, Record{value, placement}});
+}
+
+void SimDatabase::merge(SimDatabase& other){
+    generations.merge(other.generations);
 }
 
 unsigned long SimDatabase::get(const std::string& key) const {
-    return generations.at(key);
+    auto it = generations.find(key);
+    if(it == generations.end()) throw std::out_of_range("SimDatabase::get: unknown key");
+    return it->second.gen;
 }
 
 }  // namespace life
@@ -14,12 +14,16 @@
 #define _LIFE_H_
 
 #include <cassert>
+#include <cctype>
+#include <cstdint>
 #include <cstring>  // std::memcpy().
 #include <iostream>
 #include <set>
 #include <sstream>  // std::ostringstream
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 #include <fstream> // To generate images.
 
@@ -31,65 +35,205 @@ using std::string;
 using std::vector;
 
 #include "../lib/canvas.h"
+#include "fixed_board.h"
 
 namespace life {
+/// Styles available to print the life table on the terminal.
+enum class TextStyle {
+    ASCII,     //!< One character per cell.
+    HALFBLOCK, //!< One glyph per 1x2 cells (column x rows).
+    BRAILLE    //!< One glyph per 2x4 cells (columns x rows).
+};
+
 struct Cell{
     int row;
     int col;
     Cell(int r, int c) : row(r), col(c) {};
 };
 
+/// The smallest rectangle holding every alive cell (inclusive bounds).
+struct BoundingBox {
+    size_t top{0};    //!< First row with an alive cell.
+    size_t left{0};   //!< First column with an alive cell.
+    size_t bottom{0}; //!< Last row with an alive cell.
+    size_t right{0};  //!< Last column with an alive cell.
+    bool empty{true}; //!< True if there are no alive cells, in which case the bounds mean nothing.
+};
+
+/// The part of the table drawn on images, and how much it is reduced.
+struct ImageView {
+    size_t x{0};      //!< First column drawn.
+    size_t y{0};      //!< First row drawn.
+    size_t width{0};  //!< Columns drawn (0 for up to the last one).
+    size_t height{0}; //!< Rows drawn (0 for up to the last one).
+    size_t scale{1};  //!< Each pixel stands for scale x scale cells, shaded by how many of them are alive.
+
+    /// Returns true if the whole table is drawn, a cell per pixel.
+    bool whole(size_t rows, size_t cols) const {
+        return x == 0 and y == 0 and (width == 0 or width >= cols) and (height == 0 or height >= rows) and scale == 1;
+    }
+    /// Returns the view limited to a table of the given size, with its width, height and scale set.
+    ImageView clamp(size_t rows, size_t cols) const;
+    /// Returns the columns of the image (before block_size), once clamped.
+    size_t pixel_cols(void) const { return (width + scale - 1)/scale; }
+    /// Returns the rows of the image (before block_size), once clamped.
+    size_t pixel_rows(void) const { return (height + scale - 1)/scale; }
+    /// Returns how many shades above the background a pixel can take.
+    size_t shades(void) const { return std::min<size_t>(scale*scale, 255); }
+    /// Returns the colors of the shades, from `bg_color` (index 0) to `alive` (index shades()).
+    std::vector<Color> palette(Color bg_color, Color alive) const;
+};
+
+/// Reads a viewport written as "x,y,w,h" into `view`. Returns false if it is malformed.
+bool parse_viewport(const std::string& text, ImageView& view);
+/// Reads a scale written as "1/N" (or "1") into `view`. Returns false if it is malformed.
+bool parse_scale(const std::string& text, ImageView& view);
+
+/// Where the cells of a generation were, and how they were turned, for keys that don't depend on it.
+struct Placement {
+    uint8_t symmetry{0}; //!< Rotation or reflection (0 to 7) that takes the cells to their key.
+    long top{0};         //!< First row of the bounding box.
+    long left{0};        //!< First column of the bounding box.
+};
+
+/// An initial configuration read from a file.
+struct Pattern {
+    size_t rows{0};          //!< Number of rows of the table.
+    size_t cols{0};          //!< Number of columns of the table.
+    char alive_char{'*'};    //!< Character that represents an alive cell.
+    std::vector<Cell> cells; //!< The alive cells, row by row.
+};
+
+/// Reads a .dat or .rle file into `pattern`. Returns false if the file cannot be read.
+bool load_pattern(const std::string& file_name, Pattern& pattern);
+
 /// A life configuration.
 class LifeCfg {
 
    public:
     LifeCfg(const vector<Cell>& input_cell, size_t rows, size_t cols);  // lines, columns
-    ~LifeCfg(){ /* empty */ };
+    /// Creates a table that takes over the storage of `input_cell`.
+    LifeCfg(vector<Cell>&& input_cell, size_t rows, size_t cols);
+    LifeCfg(const LifeCfg&) = default;
+    LifeCfg(LifeCfg&&) = default;
+    LifeCfg& operator=(const LifeCfg&) = default;
+    LifeCfg& operator=(LifeCfg&&) = default;
 
     /// Returns a unique key for the current alive cells.
     std::string get_key(void) const;
-    /// Returns a map for the cells and how many neighbours it has.
+    /// Returns a key for the shape of the alive cells, whatever their position, rotation or reflection, and where and how they are placed.
+    std::string get_canonical_key(Placement& placement) const;
+    /// Returns a map for the cells and how many neighbours it has (built on each call).
     std::unordered_map<std::string, unsigned> get_neighbours(void) const;
     /// Returns a vector with the cells of the next generation.
     std::vector<Cell> get_next_gen(void);
-    /// Returns true if the given cell is alive.
-    bool is_alive(const Cell& cell);
-    /// Returns the alive cells.
-    std::vector<Cell> get_alive_cells(void) const;
-    /// Prints the current life table.
-    void print_life(char alive_char);
+    /// Advances the table to the next generation, in place, with its FixedBoard if its size has one.
+    void step(void);
+    /// Advances the table like step(), with the dynamic engine whatever its size.
+    void step_sliced(void);
+    /// Advances the table like step(), with a table of the next state of every 4x4 tile instead of bitwise adders.
+    void step_lut(void);
+    /// Returns true if the given cell is alive (false outside the table).
+    bool is_alive(const Cell& cell) const;
+    /// Returns the alive cells, row by row; the reference is valid until the table changes.
+    const std::vector<Cell>& get_alive_cells(void) const { return alive_cells; }
+    /// Returns how many cells are alive.
+    size_t population(void) const { return alive_cells.size(); }
+    /// Returns the number of rows of the table.
+    size_t rows(void) const { return r_rows; }
+    /// Returns the number of columns of the table.
+    size_t cols(void) const { return r_cols; }
+    /// Returns how many cells were born in the last step().
+    size_t births(void) const { return n_births; }
+    /// Returns how many cells died in the last step().
+    size_t deaths(void) const { return n_deaths; }
+    /// Returns the bounding box of the alive cells.
+    const BoundingBox& bounding_box(void) const { return box; }
+    /// Prints the current life table with the given text style.
+    void print_life(char alive_char, TextStyle style = TextStyle::ASCII);
+    /// Appends the current life table to `out`, as print_life() would print it.
+    void render_text(std::string& out, char alive_char, TextStyle style = TextStyle::ASCII) const;
     /// Returns true if there are no more alive cells.
     bool is_empty(void);
-    /// Sets a canvas with a given block size and current alive cells.
-    void set_life_canvas(short block_size, Color bg_color, Color alive);
+    /// Sets a canvas with a given block size and current alive cells, of the given part of the table.
+    void set_life_canvas(short block_size, Color bg_color, Color alive, const ImageView& view = ImageView{});
     /// Saves image of current life_canvas.
-    bool save_img(std::string path, std::string file_name);
+    bool save_img(std::string_view path, std::string_view file_name);
+    /// Saves image of current life_canvas as a PNG, with its palette, at the given compression level (0 to 9).
+    bool save_png(std::string_view path, std::string_view file_name, int level = 6);
+    /// Writes the palette indices of pixel row `y` of a clamped `view` into `out`; `counts` is scratch space.
+    void shade_row(const ImageView& view, size_t y, std::vector<uint32_t>& counts, Canvas::component_t* out) const;
+    /// Returns the canvas drawn by the last set_life_canvas().
+    const Canvas& canvas(void) const { return life_table; }
+    /// Saves the current alive cells as a RLE file.
+    bool save_rle(std::string_view path, std::string_view file_name) const;
 
     /*============= OPERATORS =============*/
 
-    /// Changes the current alive cells and updates the neighbours of each cell.
-    void operator=(std::vector<Cell> new_cells){    
-        *this = LifeCfg(new_cells, r_rows, r_cols);
+    /// Changes the current alive cells, keeping the size of the table and its buffers.
+    LifeCfg& operator=(const std::vector<Cell>& new_cells){
+        return *this = std::vector<Cell>(new_cells);
     }
+    /// Changes the current alive cells to `new_cells`, taking over their storage.
+    LifeCfg& operator=(std::vector<Cell>&& new_cells);
 
     private:
     std::vector<Cell> alive_cells; // List of cells that are alive.
-    std::unordered_map<std::string, unsigned> neighbours; // Maps how many neighbours a cell has.
 
     size_t r_rows, r_cols;
 
+    std::vector<uint64_t> bits; // Alive cells packed as bits, 64 cells per word, row by row.
+    size_t words_per_row;       // How many words a row of `bits` takes.
+    FixedStep fixed_step;       // Step of the FixedBoard of this size, or nullptr.
+    std::vector<uint64_t> next_bits; // Scratch space of step_sliced() and step_lut(), kept between generations.
+    BoundingBox box;            // Bounding box of the alive cells.
+    size_t n_births{0}, n_deaths{0}; // Cells born and dead in the last step().
+
     Canvas life_table;
+    Color canvas_bg;            // Background of life_table.
+    BoundingBox canvas_box;     // Bounding box drawn on life_table, the only part to clear on the next frame.
+    std::vector<uint32_t> view_counts;        // Alive cells under each pixel of a row, when drawing an ImageView.
+    std::vector<Canvas::component_t> view_row; // Palette indices of a row, when drawing an ImageView.
+
+    /// Returns the word of `bits` holding the given column of the given row (zero outside the table).
+    uint64_t row_word(size_t row, size_t col) const {
+        return row < r_rows ? bits[row*words_per_row + col/64] : 0;
+    }
+    /// Draws the part of the table in `view` on life_table, shading each pixel by how many of its cells are alive.
+    void draw_view(short block_size, Color bg_color, Color alive, const ImageView& view);
+    /// Moves `next_bits`, the new state of the given rows and words, into `bits`, and rebuilds the cells.
+    void commit_next(size_t top, size_t bottom, size_t first_word, size_t last_word);
+    /// Sets `bits` and `box` from `alive_cells`, which may be in any order (and the births and deaths to zero).
+    void pack_cells(void);
+    /// Rebuilds `alive_cells` and `box` from `bits`, looking only inside the given rows and words.
+    void collect_cells(size_t top, size_t bottom, size_t first_word, size_t last_word);
 };
 
 class SimDatabase{
+    public:
+     /// A generation stored in the database, and where its cells were.
+     struct Record {
+         unsigned long gen;   //!< The generation.
+         Placement placement; //!< Position and symmetry of its cells (canonical databases only).
+     };
+
     private:
-     std::unordered_map<std::string, unsigned long> generations;
+     std::unordered_multimap<std::string, Record> generations; // Every key holds one record per symmetry seen.
+     bool m_canonical;       // Whether keys are canonical (see get_canonical_key()).
      
     public:
-     SimDatabase(); // Constructor
+     SimDatabase() : SimDatabase(false) {} // Constructor
+     explicit SimDatabase(bool canonical);
+     bool canonical(void) const { return m_canonical; } // Returns true if keys don't depend on position, rotation or reflection.
+     std::string key(const LifeCfg& table, Placement& placement) const; // Returns the key of the table for this database.
      bool find(const std::string& key) const; // Returns true if key exists.
-     void insert(const std::string& key, unsigned long value); // Inserts key into database (generations).
+     const Record* find(const std::string& key, const Placement& placement) const; // Returns the record of key with the same symmetry, if any.
+     void insert(const std::string& key, unsigned long value, const Placement& placement = Placement{}); // Inserts key into database (generations).
+     void merge(SimDatabase& other); // Moves the records of other, none of which may be here already, into this database.
      unsigned long get(const std::string& key) const; // Returns the generation number of given key.
+     size_t size(void) const { return generations.size(); } // Returns how many records were inserted.
+     auto begin(void) const { return generations.begin(); } // Iterators over the (key, record) pairs.
+     auto end(void) const { return generations.end(); }
 };
 
 }  // namespace life
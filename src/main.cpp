@@ -26,16 +26,34 @@
 #include <fstream>
 #include <sstream>
 #include <chrono>
-#include <thread>
+#include <optional>
+#include <utility>
 
 #include "../lib/tip.h"
 #include "life.h"
+#include "pacer.h"
+#include "simulation.h"
+#include "batch.h"
+#include "soup.h"
+#include "census.h"
+#include "checkpoint.h"
+#include "config.h"
+#include "output.h"
+#include "image.h"
+#include "benchmark.h"
+#include "scanline.h"
+#include "video.h"
 
 int main(int argc, char* argv[])
 {
-    int rows, columns;
-    char alive_char;
-    std::string config_path = argc == 1 ? ".config/glife.ini" : argv[1];
+    // Usage: glife [config.ini] [--resume checkpoint]
+    std::string config_path = ".config/glife.ini";
+    std::string resume_path;
+    for(int i{1}; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "--resume" and i+1 < argc) resume_path = argv[++i];
+        else config_path = arg;
+    }
 
     TIP reader{ config_path };
  
@@ -45,21 +63,144 @@ int main(int argc, char* argv[])
         return EXIT_FAILURE;
     }
 
-    auto fps = reader.get_int("text", "fps"); // Tries to get info of how much fps the app will run.
-    auto max_gen = reader.get_int("ROOT", "max_gen"); // Tries to get max generations number from config file.
-    auto input_cfg = reader.get_str("ROOT", "input_cfg"); // Tries to get info of where the data is stored.
-    auto create_img = reader.get_bool("image", "generate_image"); // Tries to get whether images should or not be generated.
-    auto bk_color = reader.get_str("image", "bkg"); // Tries to get the background color.
-    auto alive_color = reader.get_str("image", "alive"); // Tries to get color of alive cell.
-    auto block_size = reader.get_int("image", "block_size"); // Tries to get the block size.
-    auto path = reader.get_str("image", "path"); // Tries to get the path in which the image will be saved.
+    // Reads every setting at once; misspelled fields and invalid values are errors.
+    life::GlifeConfig cfg;
+    if(not reader.load(cfg, life::config_schema)){
+        for(const auto& error : reader.schema_errors())
+            std::cout << "\033[1;31mError: \033[0m" << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    auto fps = cfg.fps; // How much fps the app will run.
+    auto max_gen = cfg.max_gen; // Max generations number.
+    const auto& input_cfg = cfg.input_cfg; // Where the data is stored.
+    auto create_img = cfg.generate_image; // Whether images should or not be generated.
+    const auto& bk_color = cfg.bkg; // The background color.
+    const auto& alive_color = cfg.alive; // Color of alive cell.
+    auto block_size = cfg.block_size; // The block size.
+    const auto& path = cfg.image_path; // The path in which the image will be saved.
+    // How the simulation will run; by default it follows generate_image.
+    std::string mode = cfg.mode == "auto" ? (create_img ? "image" : "text") : cfg.mode;
+    life::EscapeSettings escape; // The settings of the escaping ships detection.
+    escape.enabled = cfg.escape_enabled;
+    escape.check_every = cfg.escape_check_every;
+    escape.remove = cfg.escape_remove;
+    escape.max_period = cfg.escape_max_period;
+    life::CheckpointSettings checkpoint_settings; // The settings of the periodic checkpoints.
+    checkpoint_settings.path = cfg.checkpoint_path;
+    checkpoint_settings.every_gen = cfg.checkpoint_every_gen;
+    checkpoint_settings.every_sec = cfg.checkpoint_every_sec;
+    life::SoupSettings soup; // The settings of a soup search.
+    soup.rows = cfg.soup_rows;
+    soup.cols = cfg.soup_cols;
+    soup.density = cfg.soup_density;
+    soup.seed = cfg.soup_seed;
+    soup.count = cfg.soup_count;
+    soup.max_gen = cfg.soup_max_gen;
+    soup.threads = cfg.soup_threads;
+    soup.escape = escape;
     bool unstoppable = max_gen == 0; // Verifies if a max_gen exists.
+    life::SimOptions options; // How headless and batch runs go.
+    options.max_gen = unstoppable ? 0 : max_gen;
+    options.escape = escape;
+    options.checkpoint = checkpoint_settings;
+    life::MetricsSettings metrics_settings; // The settings of the metrics stream.
+    metrics_settings.enabled = cfg.metrics_enabled;
+    metrics_settings.path = cfg.metrics_path;
+    metrics_settings.binary = cfg.metrics_format == "binary";
+    metrics_settings.buffer = cfg.metrics_buffer;
+    options.metrics = metrics_settings;
+    options.canonical = cfg.canonical;
+    options.cache.enabled = cfg.cache_enabled;
+    options.cache.path = cfg.cache_path;
+
+    // Part of the table drawn on images, and how much it is reduced.
+    life::ImageView view;
+    if(not cfg.viewport.empty() and not life::parse_viewport(cfg.viewport, view)){
+        std::cout << "\033[1;31mError: \033[0m[image] viewport: must be x,y,w,h, with a positive width and height.\n";
+        return EXIT_FAILURE;
+    }
+    if(not life::parse_scale(cfg.scale, view)){
+        std::cout << "\033[1;31mError: \033[0m[image] scale: must be 1/N, with N at least 1.\n";
+        return EXIT_FAILURE;
+    }
+
+    // Translates the text style into the one used by the life table.
+    life::TextStyle style = life::TextStyle::ASCII;
+    if(cfg.style == "halfblock") style = life::TextStyle::HALFBLOCK;
+    else if(cfg.style == "braille") style = life::TextStyle::BRAILLE;
+
+    // Batch runs simulate many files at once, instead of input_cfg.
+    if(mode == "batch"){
+        auto files = life::expand_inputs(cfg.batch_input);
+        if(files.empty()){
+            std::cout << "\033[1;31mError: \033[0mNo input files found in " << cfg.batch_input << ".\n";
+            return EXIT_FAILURE;
+        }
+        auto start = std::chrono::steady_clock::now();
+        // Checkpoints and metrics are meant for a single long run.
+        options.checkpoint = {};
+        options.metrics = {};
+        auto entries = life::run_batch(files, options, cfg.batch_threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if(not life::write_summary(cfg.batch_summary, entries)){
+            std::cout << "\033[1;31mError: \033[0mCannot write summary to " << cfg.batch_summary << ".\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Simulated " << entries.size() << " files in " << seconds << "s ("
+                  << (seconds > 0 ? entries.size() / seconds : 0.0) << " files/sec), summary in " << cfg.batch_summary << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    // Soup searches run random tables, instead of input_cfg.
+    if(mode == "soup"){
+        auto census = life::soup_search(soup);
+        std::cout << std::fixed << std::setprecision(1)
+                  << "Soups/sec: " << (census.seconds > 0 ? census.soups / census.seconds : 0.0) << "\n"
+                  << census.soups << " soups: " << census.stable << " stable, " << census.extinct << " extinct, "
+                  << census.unstable << " unstable after " << soup.max_gen << " generations\n"
+                  << census.objects.size() << " distinct objects found in the stable soups. Most common:\n";
+        for(size_t i{0u}; i < census.objects.size() and i < size_t(cfg.soup_top); i++){
+            const auto& object = census.objects[i];
+            std::cout << "  " << std::hex << std::setw(16) << std::setfill('0') << object.hash << std::dec << std::setfill(' ')
+                      << "  " << object.name << ", count " << object.count << ", population " << object.population
+                      << ", period " << object.period << ", first in soup " << object.soup << "\n";
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Benchmarks compare the implementations of the hot paths on input_cfg.
+    if(mode == "benchmark"){
+        life::Pattern pattern;
+        if(not life::load_pattern(input_cfg, pattern)){
+            std::cout << "Cannot open file in " << input_cfg << '\n';
+            return EXIT_FAILURE;
+        }
+        life::BenchmarkSettings bench;
+        bench.generations = cfg.bench_generations;
+        bench.block_size = block_size;
+        bench.bkg = life::color_pallet[bk_color];
+        bench.alive = life::color_pallet[alive_color];
+        bench.path = path;
+        bench.png_level = cfg.png_level;
+        bench.threads = cfg.image_threads;
+        bench.view = view;
+        if(not cfg.bench_patterns.empty()){
+            auto files = life::expand_inputs(cfg.bench_patterns);
+            if(files.empty()) std::cout << "No patterns found in " << cfg.bench_patterns << ".\n";
+            else life::benchmark_engines(files, bench, std::cout);
+        }
+        life::benchmark_images(pattern, bench, std::cout);
+        return EXIT_SUCCESS;
+    }
 
-    std::transform(bk_color.begin(), bk_color.end(), bk_color.begin(), ::tolower);
-    std::transform(alive_color.begin(), alive_color.end(), alive_color.begin(), ::tolower);
+    // The run mode takes precedence over generate_image.
+    bool headless = mode == "headless";
+    create_img = mode == "image";
 
-    // Verifies if there's a risk of overcharging disk.
-    if(create_img and unstoppable) {
+    // Verifies if there's a risk of overcharging disk (raw video goes to a pipe or command, usually).
+    bool to_video = (headless ? cfg.dump_format : cfg.image_format) == "rawvideo";
+    if(resume_path.empty() and (headless ? cfg.dump_every > 0 : create_img) and unstoppable and not to_video) {
         std::cout << "\033[1;31mWARNING: \033[0m Risk of generating too many images and overchargin hard disk.\n"
         << "Do you want to continue? [S/n]: \n";
         char answer;
@@ -77,75 +218,180 @@ int main(int argc, char* argv[])
 
     // Here we are reading the file representing the table's configuration, and saving
     // it's dimensions and values where the living cells are located.
-    std::ifstream input{input_cfg};
-    if(not input.is_open()){
+    life::Pattern pattern;
+    bool loaded = life::load_pattern(input_cfg, pattern);
+    // When resuming, the table comes from the checkpoint; input_cfg only gives the alive character.
+    life::Checkpoint checkpoint;
+    bool resuming = not resume_path.empty();
+    if(resuming){
+        if(not life::load_checkpoint(resume_path, checkpoint)){
+            std::cout << "\033[1;31mError: \033[0mCannot read checkpoint " << resume_path << ".\n";
+            return EXIT_FAILURE;
+        }
+        pattern.rows = checkpoint.rows;
+        pattern.cols = checkpoint.cols;
+        pattern.cells = std::move(checkpoint.cells);
+        loaded = true;
+        std::cout << "Resuming from generation " << checkpoint.gen << "\n";
+    }
+    if(not loaded){
         std::cout << "Cannot open file in " << input_cfg << '\n';
     }
     else{
-        std::string line;
-
-        // Getting rows and columns
-        std::getline(input, line);
-        size_t space_idx = line.find(" ");
-        rows = std::stoi(line.substr(0, space_idx));
-        columns = std::stoi(line.substr(space_idx+1, line.length()));
-
-        // Getting character that represents alive cell.
-        std::getline(input, line);
-        alive_char = line[0];
-
-        // Getting positions of living cells.
-        int current_row = 0;
-        std::vector<life::Cell> alive_cells;
-        while(std::getline(input, line)){
-            for(int column{0u}; column < columns; column++){
-                if(line[column] == alive_char){
-                    alive_cells.push_back({current_row, column});
-                }
-            }
-
-            current_row++;
+        char alive_char = pattern.alive_char;
+        life::LifeCfg current_table(std::move(pattern.cells), pattern.rows, pattern.cols);
+        if(view.x >= pattern.cols or view.y >= pattern.rows){
+            std::cout << "\033[1;31mError: \033[0m[image] viewport: starts outside the " << pattern.rows << "x" << pattern.cols << " table.\n";
+            return EXIT_FAILURE;
         }
 
-        life::LifeCfg current_table(alive_cells, rows, columns);
-        life::SimDatabase database;
-        database.insert(current_table.get_key(), 1);
-
-        // Here starts the repetitions.
-        int gen{1u};
-        if(unstoppable) max_gen = gen+1;
-        if(create_img) std::cout << "Generating images...\n";
-        while(not current_table.is_empty() and gen < max_gen+1){
-            if(unstoppable) max_gen++;
-            if(not create_img){
-                std::cout << "Generation: " << gen << "\n";
-                current_table.print_life(alive_char);
-                std:cout << "\n\n";
+        // PNG images are encoded on a thread pool, while the simulation goes on (unless they are streamed).
+        std::optional<life::ImageWriter> png_writer;
+        if(not cfg.image_streaming and (headless ? cfg.dump_format == "png" : create_img and cfg.image_format == "png")){
+            png_writer.emplace(cfg.image_threads, cfg.png_level);
+        }
+        size_t stream_failures{0}; // Streamed images that could not be written.
+        // Raw video frames go to a file, a pipe or a command, which encodes them while the simulation goes on.
+        std::optional<life::VideoWriter> video;
+        if(to_video and (headless or create_img)){
+            life::VideoSettings video_settings;
+            video_settings.output = cfg.video_output;
+            video_settings.command = cfg.video_command;
+            video_settings.fps = cfg.video_fps;
+            video.emplace(video_settings);
+        }
+        // Draws the table and saves it as a ppm or png image.
+        auto save_image = [&](life::LifeCfg& table, const std::string& file_name, const std::string& format){
+            if(format == "rawvideo"){
+                life::TableScanlines source{table, short(block_size), life::color_pallet[bk_color], life::color_pallet[alive_color], view};
+                video->write(source);
+                return;
+            }
+            std::string file = path + (path.empty() or path.back() == '/' ? "" : "/") + file_name + "." + format;
+            if(cfg.image_streaming){
+                // Written row by row from the cells, with no canvas.
+                life::TableScanlines source{table, short(block_size), life::color_pallet[bk_color], life::color_pallet[alive_color], view};
+                bool ok = format == "png" ? life::stream_png(file, source, cfg.png_level) : life::stream_ppm(file, source);
+                if(not ok) stream_failures++;
+                return;
+            }
+            table.set_life_canvas(block_size, life::color_pallet[bk_color], life::color_pallet[alive_color], view);
+            if(format == "png") png_writer->submit(table.canvas(), file);
+            else table.save_img(path, file_name);
+        };
+        // Waits for the PNG images still being encoded.
+        auto finish_images = [&]{
+            if((png_writer and png_writer->wait() > 0) or stream_failures > 0){
+                std::cout << "\033[1;31mError: \033[0mCannot write some images to " << path << ".\n";
+            }
+            if(video and not video->close()){
+                std::cout << "\033[1;31mError: \033[0mCannot write the video to " << video->target() << ".\n";
             }
-            else{
-                // Generating images.
+        };
+
+        // Headless runs skip all rendering and pacing; only the selected generations are saved.
+        if(headless){
+            auto dump = [&](life::LifeCfg& table, unsigned long gen){
                 std::string file_name = "gen " + std::to_string(gen);
-                current_table.set_life_canvas(block_size, life::color_pallet[bk_color], life::color_pallet[alive_color]);
-                current_table.save_img(path, file_name);
-            }   
-                current_table = current_table.get_next_gen();
-        
-                if(database.find(current_table.get_key()) and gen != max_gen){
-                    std::cout << "Generation " << gen+1 << " found match with generation " << database.get(current_table.get_key()) << "\n";
+                if(cfg.dump_format == "rle"){
+                    table.save_rle(path, file_name);
+                }
+                else{
+                    save_image(table, file_name, cfg.dump_format);
+                }
+            };
+            // A result already in the cache is given at once; runs that save generations or metrics go on as usual.
+            bool use_cache = options.cache.enabled and not resuming and cfg.dump_every == 0 and not cfg.dump_last
+                             and not options.metrics.enabled;
+            life::ResultCache cache{options.cache.path};
+            life::CacheKey key;
+            if(use_cache){
+                key = life::cache_key(current_table, options);
+                life::SimResult cached;
+                size_t population{0};
+                if(cache.find(key, cached, population)){
+                    std::cout << cached.message() << "\n";
+                    if(escape.enabled and escape.remove and cached.ships > 0){
+                        std::cout << cached.ships << " escaping ships were deleted\n";
+                    }
+                    std::cout << "Final population: " << population << " (cached in " << options.cache.path << ")\n";
                     return EXIT_SUCCESS;
                 }
+            }
+            unsigned long first_gen = resuming ? checkpoint.gen : 1;
+            auto result = life::simulate(current_table, options,
+                [&](life::LifeCfg& table, unsigned long gen){
+                    if(cfg.dump_every > 0 and gen % cfg.dump_every == 0) dump(table, gen);
+                }, resuming ? &checkpoint : nullptr);
+            if(cfg.dump_last) dump(current_table, result.generation);
+            finish_images();
+            if(use_cache and not cache.insert(key, result, current_table.population())){
+                std::cout << "\033[1;31mError: \033[0mCannot write the result to " << options.cache.path << ".\n";
+            }
+
+            std::cout << result.message() << "\n";
+            if(escape.enabled and escape.remove and result.ships > 0){
+                std::cout << result.ships << " escaping ships were deleted\n";
+            }
+            if(result.verdict == life::Verdict::STABLE or result.verdict == life::Verdict::ESCAPING){
+                life::print_census(std::cout, life::take_census(current_table.get_alive_cells()));
+            }
+            const auto& box = current_table.bounding_box();
+            if(not box.empty){
+                std::cout << "Bounding box: rows " << box.top << "-" << box.bottom << ", columns " << box.left << "-" << box.right
+                          << " (of " << current_table.rows() << "x" << current_table.cols() << ")\n";
+            }
+            std::cout << std::fixed << std::setprecision(0)
+                      << "Generations/sec: " << (result.seconds > 0 ? (result.generation - first_gen) / result.seconds : 0.0) << "\n"
+                      << "Peak memory: " << life::peak_memory_kb() << " KB\n";
+            return EXIT_SUCCESS;
+        }
 
-                gen++;
-                database.insert(current_table.get_key(), gen);          
+        // Here starts the repetitions.
+        if(create_img) std::cout << "Generating images...\n";
 
-                // Delay based on given fps parameter.
-                if(not create_img) std::this_thread::sleep_for(std::chrono::milliseconds(1000/fps));
+        // Keeps the text output at the given fps; images are generated as fast as possible.
+        life::FramePacer pacer{create_img ? 0 : fps};
+        // Frames are written by their own thread, so a slow terminal doesn't slow the simulation down.
+        std::optional<life::TextOutput> output;
+        if(not create_img) output.emplace();
+        pacer.start();
+        bool in_frame{false}, rendered{false}; // Whether a generation is being paced, and whether it was rendered.
+        auto result = life::simulate(current_table, options,
+            [&](life::LifeCfg& table, unsigned long gen){
+                if(create_img){
+                    save_image(table, "gen " + std::to_string(gen), cfg.image_format);
+                    return;
+                }
+                // A generation ends when the next one begins, and waits for its deadline then.
+                if(in_frame) pacer.end_frame(rendered);
+                pacer.begin_frame();
+                in_frame = true;
+                rendered = false;
+                // Generations are only printed while we can keep up with the fps.
+                if(pacer.should_render()){
+                    auto& frame = output->frame();
+                    frame += "Generation: " + std::to_string(gen) + "\n";
+                    table.render_text(frame, alive_char, style);
+                    frame += "\n\n";
+                    output->submit();
+                    rendered = true;
+                }
+            }, resuming ? &checkpoint : nullptr);
+        if(in_frame) pacer.end_frame(rendered);
+        finish_images();
+        if(output){
+            output->finish();
+            pacer.report(std::cout);
+            if(output->dropped() > 0){
+                std::cout << "Terminal: " << output->written() << " frames written, " << output->dropped()
+                          << " replaced by newer ones before it caught up\n";
+            }
         }
-        if(gen == max_gen+1){
-            std::cout << "Reached limit of generations\n";
-            return EXIT_SUCCESS;
+        std::cout << result.message() << "\n";
+        if(result.verdict == life::Verdict::STABLE or result.verdict == life::Verdict::ESCAPING){
+            life::print_census(std::cout, life::take_census(current_table.get_alive_cells()));
         }
-        std::cout << "The population has been extinguished\n";
     }
 
     return EXIT_SUCCESS;
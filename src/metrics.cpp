@@ -0,0 +1,114 @@
+/**
+ * Metrics implementation.
+ *
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace life {
+
+/// Identifies a binary metrics log, and the version of its layout.
+constexpr char METRICS_MAGIC[4]{ 'G', 'L', 'M', 'T' };
+constexpr uint32_t METRICS_VERSION = 1;
+
+/*!
+ * The CSV file starts with a header line. The binary log (native byte
+ * order) starts with a magic and a version, followed by the samples as
+ * five uint64 each: gen, population, births, deaths and step_ns.
+ * Headers are only written to empty files, so appended runs stay readable.
+ */
+MetricsRecorder::MetricsRecorder(const MetricsSettings& settings, bool append)
+    : m_settings{settings}
+{
+    if(not m_settings.enabled) return;
+    m_file = std::fopen(m_settings.path.c_str(), append ? "ab" : "wb");
+    if(m_file == nullptr){
+        std::cerr << "Cannot write metrics to " << m_settings.path << "\n";
+        return;
+    }
+    if(std::ftell(m_file) == 0){
+        if(m_settings.binary){
+            std::fwrite(METRICS_MAGIC, 1, 4, m_file);
+            std::fwrite(&METRICS_VERSION, sizeof(METRICS_VERSION), 1, m_file);
+        }
+        else{
+            std::fputs("gen,population,births,deaths,step_ns\n", m_file);
+        }
+    }
+    m_ring.resize(std::max<size_t>(2, m_settings.buffer));
+    m_wake = m_ring.size()/2;
+    m_thread = std::thread([this]{ work(); });
+}
+
+MetricsRecorder::~MetricsRecorder(){
+    if(not m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+    std::fclose(m_file);
+}
+
+void MetricsRecorder::record(const MetricsSample& sample){
+    if(m_file == nullptr) return;
+    size_t head = m_head.load(std::memory_order_relaxed);
+    // Full: waits for the writer instead of dropping samples.
+    if(head - m_tail.load(std::memory_order_acquire) == m_ring.size()){
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_cv.notify_one();
+        m_space.wait(lock, [&]{ return head - m_tail.load(std::memory_order_acquire) < m_ring.size(); });
+    }
+    m_ring[head % m_ring.size()] = sample;
+    m_head.store(head + 1, std::memory_order_release);
+    // The lock is only taken once every half buffer.
+    if(head + 1 >= m_wake){
+        m_wake = head + 1 + m_ring.size()/2;
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_cv.notify_one();
+    }
+}
+
+void MetricsRecorder::work(void){
+    bool stop{false};
+    while(not stop){
+        size_t tail = m_tail.load(std::memory_order_relaxed), head;
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_cv.wait(lock, [&]{ return m_stop or m_head.load(std::memory_order_acquire) - tail >= m_ring.size()/2; });
+            head = m_head.load(std::memory_order_acquire);
+            stop = m_stop;
+        }
+        write(tail, head);
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_tail.store(head, std::memory_order_release);
+        }
+        m_space.notify_one();
+    }
+    std::fflush(m_file);
+}
+
+void MetricsRecorder::write(size_t from, size_t to){
+    m_out.clear();
+    for(size_t i{from}; i < to; i++){
+        const auto& sample = m_ring[i % m_ring.size()];
+        if(m_settings.binary){
+            m_out.append(reinterpret_cast<const char*>(&sample), sizeof(sample));
+        }
+        else{
+            m_out += std::to_string(sample.gen) + ',' + std::to_string(sample.population) + ','
+                   + std::to_string(sample.births) + ',' + std::to_string(sample.deaths) + ','
+                   + std::to_string(sample.step_ns) + '\n';
+        }
+    }
+    if(std::fwrite(m_out.data(), 1, m_out.size(), m_file) != m_out.size()){
+        std::cerr << "Cannot write metrics to " << m_settings.path << "\n";
+    }
+}
+
+}  // namespace life
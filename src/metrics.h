@@ -0,0 +1,85 @@
+//! Per generation telemetry of a simulation.
+/*!
+ * @file metrics.h
+ *
+ * @details Population, births, deaths and stepping time of each generation,
+ * kept in a preallocated ring buffer and written to a CSV file or a binary
+ * log by a background thread, so the stepping loop only stores a few
+ * numbers per generation.
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace life {
+
+/// Settings of the metrics stream.
+struct MetricsSettings {
+    bool enabled{false};              //!< Whether metrics are recorded at all.
+    std::string path{"metrics.csv"};  //!< File the metrics are written to.
+    bool binary{false};               //!< Write a binary log instead of CSV.
+    size_t buffer{4096};              //!< Samples the ring buffer holds.
+};
+
+/// The metrics of one generation.
+struct MetricsSample {
+    uint64_t gen;        //!< Generation reached by the step.
+    uint64_t population; //!< Alive cells after the step.
+    uint64_t births;     //!< Cells born in the step.
+    uint64_t deaths;     //!< Cells that died in the step.
+    uint64_t step_ns;    //!< Time spent stepping, in nanoseconds.
+};
+static_assert(sizeof(MetricsSample) == 5*sizeof(uint64_t), "MetricsSample is written to the binary log as is");
+
+/// Records samples into a ring buffer, which a background thread writes to disk.
+/*!
+ * The writer is woken up each time half of the buffer is filled; if it
+ * falls behind and the buffer fills up, record() waits for it rather than
+ * dropping samples.
+ */
+class MetricsRecorder {
+   public:
+    /// Opens the output file; with `append`, samples are added to an existing one (for resumed runs).
+    explicit MetricsRecorder(const MetricsSettings& settings, bool append = false);
+    /// Writes the samples still in the buffer and stops the thread.
+    ~MetricsRecorder();
+    MetricsRecorder(const MetricsRecorder&) = delete;
+    MetricsRecorder& operator=(const MetricsRecorder&) = delete;
+
+    /// Returns true if samples are being recorded.
+    bool enabled(void) const { return m_file != nullptr; }
+    /// Stores the sample of a generation.
+    void record(const MetricsSample& sample);
+
+   private:
+    /// Loop of the writer thread.
+    void work(void);
+    /// Writes the samples in [from, to) of the ring.
+    void write(size_t from, size_t to);
+
+    MetricsSettings m_settings;             //!< The settings.
+    std::vector<MetricsSample> m_ring;      //!< The samples not written yet.
+    std::atomic<size_t> m_head{0};          //!< Samples recorded so far.
+    std::atomic<size_t> m_tail{0};          //!< Samples written so far.
+    size_t m_wake{0};                       //!< Value of m_head at which the writer is woken up next.
+    std::string m_out;                      //!< Output buffer of the writer thread.
+    FILE* m_file{nullptr};                  //!< The output file.
+    std::mutex m_mutex;                     //!< Guards the stop flag and the waits.
+    std::condition_variable m_cv;           //!< Wakes the writer thread up.
+    std::condition_variable m_space;        //!< Wakes record() up when the buffer was full.
+    bool m_stop{false};                     //!< Set when the recorder is being destroyed.
+    std::thread m_thread;                   //!< The writer thread (only if enabled).
+};
+
+}  // namespace life
+
+#endif
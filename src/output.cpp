@@ -0,0 +1,53 @@
+/**
+ * TextOutput implementation.
+ *
+ */
+
+#include "output.h"
+
+#include <cstdio>
+
+namespace life {
+
+TextOutput::TextOutput(void)
+    : m_thread{[this]{ work(); }}
+{}
+
+TextOutput::~TextOutput(){
+    finish();
+}
+
+void TextOutput::submit(void){
+    if(not m_queue.publish()) m_dropped++;
+    // The lock only makes sure the output thread is either awake or already waiting.
+    { std::lock_guard<std::mutex> lock{m_mutex}; }
+    m_cv.notify_one();
+}
+
+void TextOutput::finish(void){
+    if(not m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+void TextOutput::work(void){
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock{m_mutex};
+            m_cv.wait(lock, [this]{ return m_stop or m_queue.pending(); });
+        }
+        // The last frame is still written when stopping.
+        if(auto frame = m_queue.take()){
+            std::fwrite(frame->data(), 1, frame->size(), stdout);
+            std::fflush(stdout);
+            m_written++;
+        }
+        else if(m_stop) return;
+    }
+}
+
+}  // namespace life
@@ -0,0 +1,95 @@
+//! Terminal output on its own thread.
+/*!
+ * @file output.h
+ *
+ * @details The simulation renders each frame into a preallocated buffer and
+ * hands it to an output thread, which writes it to the terminal. A slow
+ * terminal (SSH, tmux) then only makes frames be skipped, instead of
+ * slowing the simulation down.
+ */
+
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace life {
+
+/// Single producer, single consumer queue of frames that always yields the latest one.
+/*!
+ * There are three buffers, owned by the producer (back), the consumer
+ * (front) and neither (middle). Publishing swaps the back buffer with the
+ * middle one, and taking swaps the front buffer with the middle one, each
+ * with a single atomic exchange, so neither side ever waits for the other.
+ * A frame published before the previous one was taken replaces it.
+ */
+class FrameQueue {
+   public:
+    /// Returns the buffer the producer renders the next frame into.
+    std::string& back(void){ return m_frames[m_back]; }
+    /// Publishes the back buffer. Returns false if it replaced a frame never taken.
+    bool publish(void){
+        auto old = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        m_back = old & INDEX;
+        return not (old & FRESH);
+    }
+    /// Returns true if there is a frame published and not taken yet.
+    bool pending(void) const { return m_middle.load(std::memory_order_acquire) & FRESH; }
+    /// Takes the latest frame published, if there is a new one; it stays valid until the next take().
+    const std::string* take(void){
+        if(not pending()) return nullptr;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+        return &m_frames[m_front];
+    }
+
+   private:
+    static constexpr uint8_t INDEX = 3; //!< Bits of m_middle holding the buffer index.
+    static constexpr uint8_t FRESH = 4; //!< Bit of m_middle set while its frame was not taken.
+
+    std::string m_frames[3];            //!< The buffers; they keep their capacity between frames.
+    uint8_t m_back{0};                  //!< Buffer of the producer.
+    uint8_t m_front{1};                 //!< Buffer of the consumer.
+    std::atomic<uint8_t> m_middle{2};   //!< Buffer in between, and whether it holds a new frame.
+};
+
+/// Writes the frames of a FrameQueue to the standard output, on a thread of its own.
+class TextOutput {
+   public:
+    TextOutput(void);
+    /// Calls finish().
+    ~TextOutput();
+    TextOutput(const TextOutput&) = delete;
+    TextOutput& operator=(const TextOutput&) = delete;
+
+    /// Returns the buffer the next frame must be rendered into (cleared).
+    std::string& frame(void){ m_queue.back().clear(); return m_queue.back(); }
+    /// Hands the rendered frame to the output thread.
+    void submit(void);
+    /// Writes the last frame, if it wasn't yet, and stops the thread; after it the standard output is free to use.
+    void finish(void);
+    /// Returns how many frames were written to the terminal.
+    size_t written(void) const { return m_written; }
+    /// Returns how many frames were replaced by newer ones before being written.
+    size_t dropped(void) const { return m_dropped; }
+
+   private:
+    /// Loop of the output thread.
+    void work(void);
+
+    FrameQueue m_queue;              //!< The frames.
+    std::mutex m_mutex;              //!< Only used to sleep while there are no frames.
+    std::condition_variable m_cv;    //!< Wakes the output thread up.
+    std::atomic<bool> m_stop{false}; //!< Set by finish().
+    size_t m_written{0};             //!< Frames written (by the output thread).
+    size_t m_dropped{0};             //!< Frames replaced (by the producer).
+    std::thread m_thread;            //!< The output thread.
+};
+
+}  // namespace life
+
+#endif
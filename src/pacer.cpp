@@ -0,0 +1,88 @@
+/**
+ * FramePacer class implementation.
+ *
+ */
+
+#include "pacer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
+namespace life {
+
+FramePacer::FramePacer(int fps)
+    : m_period{fps > 0 ? std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(1'000'000'000 / fps))
+                       : clock::duration::zero()}
+{}
+
+/*!
+ * Times below SUB_BUCKETS ns have a bucket each; above, each power of two
+ * is split in SUB_BUCKETS equal parts, so a bucket is at most 1/SUB_BUCKETS
+ * of its times wide.
+ */
+size_t FramePacer::bucket(uint64_t ns){
+    if(ns < SUB_BUCKETS) return ns;
+    size_t exponent = 63 - __builtin_clzll(ns);
+    return (exponent - 2)*SUB_BUCKETS + ((ns >> (exponent - 3)) & (SUB_BUCKETS - 1));
+}
+
+uint64_t FramePacer::bucket_floor(size_t index){
+    if(index < SUB_BUCKETS) return index;
+    size_t exponent = index/SUB_BUCKETS + 2;
+    return (SUB_BUCKETS + index%SUB_BUCKETS) << (exponent - 3);
+}
+
+void FramePacer::start(void){
+    m_start = clock::now();
+    m_deadline = m_start + m_period;
+}
+
+void FramePacer::begin_frame(void){
+    m_frame_begin = clock::now();
+}
+
+bool FramePacer::should_render(void) const {
+    // If the deadline of this generation has already passed, we are behind.
+    return m_period == clock::duration::zero() or m_frame_begin < m_deadline;
+}
+
+void FramePacer::end_frame(bool rendered){
+    auto now = clock::now();
+    auto frame_time = now - m_frame_begin;
+    m_frame_times[bucket(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_time).count())]++;
+    m_longest = std::max(m_longest, frame_time);
+    m_frames++;
+    if(rendered) m_rendered++;
+
+    if(m_period == clock::duration::zero()) return;
+    // Sleeps until the deadline, if we are ahead of it. The next deadline is always
+    // based on the previous one, so the rate doesn't drift with the frame times.
+    if(now < m_deadline) std::this_thread::sleep_until(m_deadline);
+    m_deadline += m_period;
+}
+
+void FramePacer::report(std::ostream& os) const {
+    if(m_frames == 0) return;
+
+    double elapsed = std::chrono::duration<double>(clock::now() - m_start).count();
+    double longest = std::chrono::duration<double, std::milli>(m_longest).count();
+    // Frame time, in milliseconds, at the given percentile: the top of its bucket, but no more than the longest.
+    auto percentile = [&](double p){
+        size_t rank = std::min(m_frames - 1, size_t(p * m_frames)), seen{0};
+        size_t index{0};
+        while((seen += m_frame_times[index]) <= rank) index++;
+        return std::min(longest, bucket_floor(index + 1)/1e6);
+    };
+
+    os << std::fixed << std::setprecision(2)
+       << "Achieved " << (elapsed > 0 ? m_rendered / elapsed : 0.0) << " fps ("
+       << m_rendered << " of " << m_frames << " generations rendered)\n"
+       << "Frame time (ms): p50 " << percentile(0.50)
+       << ", p90 " << percentile(0.90)
+       << ", p99 " << percentile(0.99)
+       << ", max " << longest << "\n";
+    os.unsetf(std::ios::floatfield);
+}
+
+}  // namespace life
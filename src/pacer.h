@@ -0,0 +1,67 @@
+//! This class paces the text output of the Conway's Game of Life.
+/*!
+ * @file pacer.h
+ *
+ * @details Class FramePacer, which keeps the generations at a target rate
+ * by using absolute deadlines, instead of sleeping a fixed amount after
+ * each frame.
+ */
+
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+namespace life {
+
+/// Paces the generations at a target frame rate.
+/*!
+ * Generation `n` must be finished by `start + n * period`. When a generation
+ * is done ahead of its deadline the pacer sleeps until it; when the simulation
+ * falls behind, the rendering of the late generations is skipped (the
+ * simulation itself is never skipped) until it catches up.
+ */
+class FramePacer {
+   public:
+    using clock = std::chrono::steady_clock;
+
+    /// Creates a pacer for the given frame rate. A non positive `fps` means no pacing at all.
+    explicit FramePacer(int fps);
+
+    /// Starts the clock. The first deadline is one period from now.
+    void start(void);
+    /// Marks the beginning of a generation.
+    void begin_frame(void);
+    /// Returns true if the current generation is on time and should be rendered.
+    bool should_render(void) const;
+    /// Marks the end of a generation and waits until its deadline, if there is time left.
+    void end_frame(bool rendered);
+    /// Prints the achieved frame rate and the frame time percentiles.
+    void report(std::ostream& os) const;
+
+   private:
+    /// Sub-buckets of each power of two of the frame time histogram.
+    static constexpr size_t SUB_BUCKETS = 8;
+    /// Buckets of the histogram: exact below SUB_BUCKETS ns, then SUB_BUCKETS per power of two up to 2^64 ns.
+    static constexpr size_t BUCKETS = (64 - 2)*SUB_BUCKETS;
+    /// Returns the bucket of a frame time of `ns` nanoseconds.
+    static size_t bucket(uint64_t ns);
+    /// Returns the smallest frame time, in nanoseconds, of bucket `index`.
+    static uint64_t bucket_floor(size_t index);
+
+    clock::duration m_period;              //!< Time each generation is given (zero if unpaced).
+    clock::time_point m_start;             //!< When the pacing started.
+    clock::time_point m_deadline;          //!< When the current generation must be done.
+    clock::time_point m_frame_begin;       //!< When the current generation started.
+    std::array<uint64_t, BUCKETS> m_frame_times{}; //!< Histogram of the work time (compute + render) of the generations.
+    clock::duration m_longest{0};          //!< Longest work time of a generation.
+    size_t m_frames{0};                    //!< How many generations were paced.
+    size_t m_rendered{0};                  //!< How many generations were rendered.
+};
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * Scanline image writers implementation.
+ *
+ */
+
+#include "scanline.h"
+
+#include <cstdio>
+#include <limits>
+
+#include "../lib/lodepng.h"
+#include "../lib/trace.h"
+
+namespace life {
+
+TableScanlines::TableScanlines(const LifeCfg& table, short block_size, Color bg_color, Color alive, const ImageView& view)
+    : m_table{table},
+      m_view{view.clamp(table.rows(), table.cols())},
+      m_block(block_size),
+      m_palette{m_view.palette(bg_color, alive)},
+      m_cells(m_view.pixel_cols()),
+      m_cells_row{std::numeric_limits<size_t>::max()}
+{}
+
+void TableScanlines::row(size_t y, Canvas::component_t* out){
+    if(y/m_block != m_cells_row){
+        m_cells_row = y/m_block;
+        m_table.shade_row(m_view, m_cells_row, m_counts, m_cells.data());
+    }
+    for(size_t col{0u}; col < m_cells.size(); col++, out += m_block){
+        std::memset(out, m_cells[col], m_block);
+    }
+}
+
+bool stream_ppm(const std::string& file, ScanlineSource& source){
+    TRACE_ZONE("stream_ppm");
+    FILE* out = std::fopen(file.c_str(), "wb");
+    if(out == nullptr) return false;
+    const size_t width = source.width();
+    std::fprintf(out, "P6\n%zu %zu\n255\n", width, source.height());
+
+    const auto& palette = source.palette();
+    std::vector<Canvas::component_t> indices(width);
+    std::vector<unsigned char> rgb(width*3);
+    bool ok{true};
+    for(size_t y{0u}; y < source.height() and ok; y++){
+        source.row(y, indices.data());
+        for(size_t x{0u}; x < width; x++){
+            std::memcpy(&rgb[x*3], palette[indices[x]].channels, 3);
+        }
+        ok = std::fwrite(rgb.data(), 1, rgb.size(), out) == rgb.size();
+    }
+    return std::fclose(out) == 0 and ok;
+}
+
+/// Writes `value` into `out` as 4 big endian bytes.
+static void put32(unsigned char* out, uint32_t value){
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+/// Writes a PNG chunk to `file`; `body` holds its type and then its data.
+static bool write_chunk(FILE* file, const std::vector<unsigned char>& body){
+    unsigned char length[4], crc[4];
+    put32(length, body.size() - 4);
+    put32(crc, lodepng_crc32(body.data(), body.size()));
+    return std::fwrite(length, 1, 4, file) == 4 and std::fwrite(body.data(), 1, body.size(), file) == body.size()
+           and std::fwrite(crc, 1, 4, file) == 4;
+}
+
+/// A zlib stream, written out in IDAT chunks as it grows.
+/*!
+ * Compressed streams are a single deflate block with the fixed Huffman
+ * codes, whose only matches are runs of a repeated byte (distance 1).
+ * With the Up filter, rows equal to the one above (every row of a block
+ * but the first) are all zeros, and so are the flat parts of the others,
+ * so runs are nearly all there is to find, and no window has to be kept.
+ * Uncompressed streams are made of stored blocks.
+ */
+class ZlibStream {
+   public:
+    ZlibStream(FILE* file, bool compress) : m_file{file}, m_compress{compress} {
+        m_chunk.assign({'I', 'D', 'A', 'T', 0x78, 0x01});
+        if(m_compress){
+            put_bits(1, 1);  // Last block,
+            put_bits(1, 2);  // with fixed Huffman codes.
+        }
+    }
+
+    /// Appends `size` bytes to the stream.
+    void write(const unsigned char* data, size_t size){
+        for(size_t i{0u}; i < size; i++){
+            m_adler_a = (m_adler_a + data[i]) % 65521;
+            m_adler_b = (m_adler_b + m_adler_a) % 65521;
+        }
+        if(not m_compress){
+            m_stored.insert(m_stored.end(), data, data + size);
+            while(m_stored.size() >= MAX_STORED) store(MAX_STORED, false);
+            return;
+        }
+        for(size_t i{0u}; i < size; i++){
+            if(m_has_last and data[i] == m_last){
+                if(++m_run == MAX_RUN) flush_run();
+                continue;
+            }
+            flush_run();
+            literal(data[i]);
+            m_last = data[i];
+            m_has_last = true;
+        }
+    }
+
+    /// Ends the stream and writes what is left of it. Returns false if any write failed.
+    bool finish(void){
+        if(m_compress){
+            flush_run();
+            literal(256);  // End of block.
+            align();
+        }
+        else{
+            store(m_stored.size(), true);
+        }
+        uint32_t adler = m_adler_b << 16 | m_adler_a;
+        for(int shift{24}; shift >= 0; shift -= 8) byte(adler >> shift);
+        flush();
+        return m_ok;
+    }
+
+   private:
+    static constexpr size_t CHUNK = 1 << 16;      //!< Size of the IDAT chunks.
+    static constexpr size_t MAX_STORED = 65535;   //!< Largest stored block.
+    static constexpr size_t MAX_RUN = 258;        //!< Longest match.
+    /// First length of each length code (257 to 285), and how many extra bits it takes.
+    static constexpr uint16_t LENGTH_BASE[29]{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                              35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr uint8_t LENGTH_EXTRA[29]{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                              3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+    /// Writes the lowest `count` bits of `value`, the least significant first.
+    void put_bits(uint32_t value, unsigned count){
+        m_bits |= uint64_t(value) << m_bit_count;
+        m_bit_count += count;
+        while(m_bit_count >= 8){
+            byte(m_bits);
+            m_bits >>= 8;
+            m_bit_count -= 8;
+        }
+    }
+    /// Writes a Huffman code of `length` bits, the most significant first.
+    void put_code(uint32_t code, unsigned length){
+        uint32_t reversed{0};
+        for(unsigned i{0u}; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+        put_bits(reversed, length);
+    }
+    /// Writes the fixed Huffman code of a literal/length symbol.
+    void literal(unsigned symbol){
+        if(symbol < 144) put_code(0x30 + symbol, 8);
+        else if(symbol < 256) put_code(0x190 + symbol - 144, 9);
+        else if(symbol < 280) put_code(symbol - 256, 7);
+        else put_code(0xC0 + symbol - 280, 8);
+    }
+    /// Writes the pending run of m_last: as a match if it is long enough, as literals otherwise.
+    void flush_run(void){
+        if(m_run >= 3){
+            size_t code{0};
+            while(code + 1 < 29 and LENGTH_BASE[code + 1] <= m_run) code++;
+            literal(257 + code);
+            put_bits(m_run - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+            put_code(0, 5);  // Distance 1.
+        }
+        else{
+            for(size_t i{0u}; i < m_run; i++) literal(m_last);
+        }
+        m_run = 0;
+    }
+    /// Writes the first `size` bytes of m_stored as a stored block.
+    void store(size_t size, bool last){
+        put_bits(last, 1);
+        put_bits(0, 2);
+        align();
+        byte(size);
+        byte(size >> 8);
+        byte(~size);
+        byte(~size >> 8);
+        for(size_t i{0u}; i < size; i++) byte(m_stored[i]);
+        m_stored.erase(m_stored.begin(), m_stored.begin() + size);
+    }
+    /// Pads the bits written to a whole byte.
+    void align(void){
+        if(m_bit_count > 0) put_bits(0, 8 - m_bit_count);
+    }
+    /// Appends a byte to the chunk being filled, writing the chunk out once it is full.
+    void byte(unsigned char value){
+        m_chunk.push_back(value);
+        if(m_chunk.size() >= 4 + CHUNK) flush();
+    }
+    /// Writes the chunk being filled.
+    void flush(void){
+        if(m_chunk.size() > 4) m_ok = write_chunk(m_file, m_chunk) and m_ok;
+        m_chunk.resize(4);
+    }
+
+    FILE* m_file;                        //!< The PNG file.
+    bool m_compress;                     //!< Whether the data is compressed, or stored.
+    bool m_ok{true};                     //!< False once a write failed.
+    std::vector<unsigned char> m_chunk;  //!< "IDAT" and the bytes of the chunk being filled.
+    std::vector<unsigned char> m_stored; //!< Bytes not yet in a stored block.
+    uint64_t m_bits{0};                  //!< Bits not yet in m_chunk.
+    unsigned m_bit_count{0};             //!< How many of m_bits are used.
+    uint32_t m_adler_a{1}, m_adler_b{0}; //!< Adler-32 of the uncompressed data.
+    unsigned char m_last{0};             //!< Last byte written as a literal.
+    bool m_has_last{false};              //!< Whether m_last is set.
+    size_t m_run{0};                     //!< Repetitions of m_last not yet written.
+};
+
+/*!
+ * Rows are packed at the smallest palette bit depth that holds the colors
+ * and filtered with Up before being compressed, so only the current and
+ * the previous row are kept.
+ */
+bool stream_png(const std::string& file, ScanlineSource& source, int level){
+    TRACE_ZONE("stream_png");
+    const size_t width = source.width(), height = source.height();
+    const auto& palette = source.palette();
+    if(width == 0 or height == 0 or palette.empty() or palette.size() > 256) return false;
+    FILE* out = std::fopen(file.c_str(), "wb");
+    if(out == nullptr) return false;
+
+    const unsigned depth = palette.size() <= 2 ? 1 : palette.size() <= 4 ? 2 : palette.size() <= 16 ? 4 : 8;
+    const unsigned char signature[8]{137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    bool ok = std::fwrite(signature, 1, 8, out) == 8;
+    std::vector<unsigned char> header{'I', 'H', 'D', 'R', 0, 0, 0, 0, 0, 0, 0, 0, (unsigned char)depth, 3, 0, 0, 0};
+    put32(&header[4], width);
+    put32(&header[8], height);
+    ok = ok and write_chunk(out, header);
+    std::vector<unsigned char> colors{'P', 'L', 'T', 'E'};
+    for(const auto& color : palette) colors.insert(colors.end(), color.channels, color.channels + 3);
+    ok = ok and write_chunk(out, colors);
+
+    ZlibStream stream{out, level > 0};
+    const size_t stride = (width*depth + 7)/8, per_byte = 8/depth;
+    std::vector<Canvas::component_t> indices(width);
+    std::vector<unsigned char> row(stride), above(stride, 0), filtered(1 + stride);
+    filtered[0] = 2;  // Up filter.
+    for(size_t y{0u}; y < height; y++){
+        source.row(y, indices.data());
+        if(depth == 8){
+            std::memcpy(row.data(), indices.data(), width);
+        }
+        else{
+            std::fill(row.begin(), row.end(), 0);
+            for(size_t x{0u}; x < width; x++){
+                row[x/per_byte] |= indices[x] << (8 - depth*(x%per_byte + 1));
+            }
+        }
+        for(size_t i{0u}; i < stride; i++) filtered[1 + i] = row[i] - above[i];
+        stream.write(filtered.data(), filtered.size());
+        row.swap(above);
+    }
+    ok = stream.finish() and ok;
+    ok = ok and write_chunk(out, {'I', 'E', 'N', 'D'});
+    return std::fclose(out) == 0 and ok;
+}
+
+}  // namespace life
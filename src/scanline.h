@@ -0,0 +1,69 @@
+//! Images written a row of pixels at a time.
+/*!
+ * @file scanline.h
+ *
+ * @details A ScanlineSource produces an image one row of pixels at a time,
+ * and stream_ppm() and stream_png() write each row out as soon as it is
+ * produced, so writing an image only takes memory for a few rows of it,
+ * whatever the height of the table and the block size. TableScanlines
+ * produces the rows straight from the cells of a LifeCfg, with no canvas.
+ */
+
+#ifndef _SCANLINE_H_
+#define _SCANLINE_H_
+
+#include <string>
+#include <vector>
+
+#include "life.h"
+
+namespace life {
+
+/// An image produced one row of palette indices at a time.
+class ScanlineSource {
+   public:
+    virtual ~ScanlineSource() = default;
+
+    /// Returns the width of the image, in pixels.
+    virtual size_t width(void) const = 0;
+    /// Returns the height of the image, in pixels.
+    virtual size_t height(void) const = 0;
+    /// Returns the colors of the indices.
+    virtual const std::vector<Color>& palette(void) const = 0;
+    /// Writes the indices of row `y` into `out` (width() of them). Rows are asked for in order, from the first.
+    virtual void row(size_t y, Canvas::component_t* out) = 0;
+};
+
+/// The image of a table, as set_life_canvas() would draw it, made from its cells row by row.
+/*!
+ * Each row of cells (or of shades, when the view is reduced) is worked
+ * out once, and then repeated over the block_size rows of pixels it takes.
+ * The table must not change while its rows are being read.
+ */
+class TableScanlines : public ScanlineSource {
+   public:
+    TableScanlines(const LifeCfg& table, short block_size, Color bg_color, Color alive, const ImageView& view = ImageView{});
+
+    size_t width(void) const override { return m_view.pixel_cols()*m_block; }
+    size_t height(void) const override { return m_view.pixel_rows()*m_block; }
+    const std::vector<Color>& palette(void) const override { return m_palette; }
+    void row(size_t y, Canvas::component_t* out) override;
+
+   private:
+    const LifeCfg& m_table;                  //!< The table drawn.
+    ImageView m_view;                        //!< Part of the table drawn, clamped to it.
+    size_t m_block;                          //!< Pixels of each side of a cell.
+    std::vector<Color> m_palette;            //!< Background, shades and alive color.
+    std::vector<uint32_t> m_counts;          //!< Scratch space of LifeCfg::shade_row().
+    std::vector<Canvas::component_t> m_cells; //!< Indices of the row of cells last worked out.
+    size_t m_cells_row;                      //!< Which row m_cells holds.
+};
+
+/// Writes the image of `source` to `file` as a binary (P6) PPM.
+bool stream_ppm(const std::string& file, ScanlineSource& source);
+/// Writes the image of `source` to `file` as a PNG; `level` 0 stores the rows, any other compresses them.
+bool stream_png(const std::string& file, ScanlineSource& source, int level);
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Headless simulation implementation.
+ *
+ */
+
+#include "simulation.h"
+
+#include <chrono>
+#include <sys/resource.h>
+#include <utility>
+
+namespace life {
+
+std::string SimResult::message(void) const {
+    switch(verdict){
+        case Verdict::EXTINCT:
+            return "The population has been extinguished";
+        case Verdict::STABLE:
+            return "Generation " + std::to_string(generation) + " found match with generation " + std::to_string(match)
+                + (canonical ? ": period " + std::to_string(period()) + ", displacement (" + std::to_string(dx) + ", "
+                                   + std::to_string(dy) + ")" : "");
+        case Verdict::ESCAPING:
+            return "Generation " + std::to_string(generation) + " is stable (period " + std::to_string(core_period)
+                + ") + " + std::to_string(ships) + " escaping ships";
+        default:
+            return "Reached limit of generations";
+    }
+}
+
+/// Generation 1 is the initial table, and the last allowed generation is not checked against the database.
+SimResult simulate(LifeCfg& table, const SimOptions& options, const GenerationVisitor& visit,
+                   Checkpoint* resume){
+    auto start = std::chrono::steady_clock::now();
+    const auto max_gen = options.max_gen;
+    SimResult result;
+    SimDatabase database{options.canonical};
+    Placement placement;
+    unsigned long gen{1u};
+    size_t ships{0u};
+    if(resume){
+        database = std::move(resume->database);
+        gen = resume->gen;
+        ships = resume->ships;
+    }
+    else{
+        auto key = database.key(table, placement);
+        database.insert(key, 1, placement);
+    }
+    result.canonical = database.canonical();
+    EscapeDetector detector{options.escape, ships};
+    CheckpointWriter checkpoints{options.checkpoint};
+    // Records added since the last checkpoint; the writer thread keeps the older ones.
+    SimDatabase new_records{database.canonical()};
+    if(options.checkpoint.enabled()) new_records = database;
+    MetricsRecorder metrics{options.metrics, resume != nullptr};
+
+    while(not table.is_empty() and (max_gen == 0 or gen <= max_gen)){
+        if(visit) visit(table, gen);
+        if(metrics.enabled()){
+            auto step_start = std::chrono::steady_clock::now();
+            table.step();
+            auto step_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - step_start).count();
+            metrics.record({gen+1, table.population(), table.births(), table.deaths(), uint64_t(step_ns)});
+        }
+        else{
+            table.step();
+        }
+
+        auto key = database.key(table, placement);
+        const auto* match = database.find(key, placement);
+        if(match and gen != max_gen){
+            result.verdict = Verdict::STABLE;
+            result.match = match->gen;
+            result.dx = placement.left - match->placement.left;
+            result.dy = placement.top - match->placement.top;
+            gen++;
+            break;
+        }
+
+        gen++;
+        database.insert(key, gen, placement);
+        if(options.checkpoint.enabled()) new_records.insert(key, gen, placement);
+
+        if(detector.check(table, gen)){
+            result.verdict = Verdict::ESCAPING;
+            result.core_period = detector.core_period();
+            break;
+        }
+
+        // The snapshot is taken here; the writer thread does the rest.
+        if(checkpoints.due(gen)){
+            checkpoints.submit(Checkpoint{gen, table.rows(), table.cols(), table.get_alive_cells(),
+                                          std::exchange(new_records, SimDatabase{database.canonical()}), detector.ships()});
+        }
+    }
+    result.generation = gen;
+    result.ships = detector.ships();
+    if(result.verdict != Verdict::STABLE and result.verdict != Verdict::ESCAPING){
+        result.verdict = max_gen != 0 and gen == max_gen+1 ? Verdict::MAX_GEN : Verdict::EXTINCT;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+long peak_memory_kb(void){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // Already in kilobytes on linux.
+}
+
+}  // namespace life
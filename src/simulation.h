@@ -0,0 +1,79 @@
+//! Runs a life configuration until it reaches a verdict.
+/*!
+ * @file simulation.h
+ *
+ * @details Stepping of a LifeCfg until it dies, stabilises (SimDatabase)
+ * or runs out of generations. Every mode runs through simulate(): the text
+ * and image modes render, save and pace each generation in its visitor.
+ */
+
+#ifndef _SIMULATION_H_
+#define _SIMULATION_H_
+
+#include <functional>
+#include <string>
+
+#include "cache.h"
+#include "checkpoint.h"
+#include "escape.h"
+#include "life.h"
+#include "metrics.h"
+
+namespace life {
+
+/// How a simulation ended.
+enum class Verdict {
+    EXTINCT,  //!< The population has been extinguished.
+    STABLE,   //!< A generation matched a previous one.
+    MAX_GEN,  //!< The limit of generations was reached.
+    ESCAPING  //!< A periodic core is left, and ships flying away from it.
+};
+
+/// Final result of a simulation.
+struct SimResult {
+    Verdict verdict{Verdict::MAX_GEN}; //!< How the simulation ended.
+    unsigned long generation{1};       //!< Generation of the final table.
+    unsigned long match{0};            //!< Generation matched by the last one (STABLE only).
+    bool canonical{false};             //!< Whether matches ignored position, rotation and reflection.
+    long dx{0}, dy{0};                 //!< Columns and rows the cells moved since the match (canonical STABLE only).
+    size_t ships{0};                   //!< Ships escaping (ESCAPING), or deleted so far.
+    unsigned long core_period{0};      //!< Period of the core left (ESCAPING only).
+    double seconds{0};                 //!< Wall time spent stepping.
+
+    /// Length of the cycle found (STABLE), or of the core left (ESCAPING).
+    unsigned long period(void) const {
+        return verdict == Verdict::STABLE ? generation - match : verdict == Verdict::ESCAPING ? core_period : 0;
+    }
+    /// Returns the verdict as a human readable message.
+    std::string message(void) const;
+};
+
+/// How a simulation should run.
+struct SimOptions {
+    unsigned long max_gen{0};       //!< Last generation (zero means no limit).
+    EscapeSettings escape;          //!< Detection of escaping ships.
+    CheckpointSettings checkpoint;  //!< Periodic checkpoints of the run.
+    MetricsSettings metrics;        //!< Per generation metrics of the run.
+    bool canonical{false};          //!< Match translated copies too (see LifeCfg::get_canonical_key()).
+    CacheSettings cache;            //!< Results kept on disk; looked up by the callers of simulate(), not by it.
+};
+
+/// Called with the table and the generation number, before each generation is stepped.
+using GenerationVisitor = std::function<void(LifeCfg&, unsigned long)>;
+
+/// Steps `table` until it dies, stabilises or reaches `options.max_gen`; only `visit` may slow it down.
+/*!
+ * With escape detection enabled, the run may also stop (or delete ships)
+ * when only ships flying away from a periodic core are left changing.
+ * If `resume` is given, the run continues from its generation and database
+ * (and `table` must hold its cells); it is left in an unspecified state.
+ */
+SimResult simulate(LifeCfg& table, const SimOptions& options, const GenerationVisitor& visit = {},
+                   Checkpoint* resume = nullptr);
+
+/// Returns the peak resident memory of this process, in kilobytes.
+long peak_memory_kb(void);
+
+}  // namespace life
+
+#endif
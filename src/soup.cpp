@@ -0,0 +1,120 @@
+/**
+ * Soup search implementation.
+ *
+ */
+
+#include "soup.h"
+#include "census.h"
+#include "simulation.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <random>
+#include <unordered_map>
+#include <utility>
+
+namespace life {
+
+Pattern random_soup(size_t rows, size_t cols, double density, uint64_t seed){
+    Pattern soup;
+    soup.rows = rows;
+    soup.cols = cols;
+    std::mt19937_64 engine{seed};
+    std::bernoulli_distribution alive{density};
+    for(size_t i{0u}; i < rows; i++){
+        for(size_t j{0u}; j < cols; j++){
+            if(alive(engine)) soup.cells.push_back({int(i), int(j)});
+        }
+    }
+    return soup;
+}
+
+/// Uses the splitmix64 finaliser, so nearby indices get unrelated seeds.
+uint64_t soup_seed(uint64_t seed, unsigned long index){
+    return mix64(seed + (index + 1) * 0x9E3779B97F4A7C15ull);
+}
+
+/// Counts of a range of soups, merged into the census at the end.
+struct SoupTally {
+    unsigned long extinct{0}, stable{0}, unstable{0};
+    std::unordered_map<uint64_t, AshObject> objects;
+};
+
+/// Runs the soups in [first, last) and tallies them.
+static SoupTally run_soups(const SoupSettings& settings, unsigned long first, unsigned long last){
+    SoupTally tally;
+    SimOptions options;
+    options.max_gen = settings.max_gen;
+    options.escape = settings.escape;
+    for(auto idx{first}; idx < last; idx++){
+        auto soup = random_soup(settings.rows, settings.cols, settings.density, soup_seed(settings.seed, idx));
+        LifeCfg table(std::move(soup.cells), soup.rows, soup.cols);
+        auto result = simulate(table, options);
+
+        if(result.verdict == Verdict::EXTINCT){
+            tally.extinct++;
+        }
+        else if(result.verdict == Verdict::MAX_GEN){
+            tally.unstable++;
+        }
+        else{
+            tally.stable++;
+            for(const auto& entry : take_census(table.get_alive_cells())){
+                auto [it, inserted] = tally.objects.try_emplace(entry.object.hash);
+                auto& object = it->second;
+                if(inserted){
+                    object.hash = entry.object.hash;
+                    object.name = entry.object.name;
+                    object.population = entry.object.population;
+                    object.period = entry.object.period;
+                    object.soup = idx;
+                }
+                object.count += entry.count;
+            }
+        }
+    }
+    return tally;
+}
+
+SoupCensus soup_search(const SoupSettings& settings){
+    auto start = std::chrono::steady_clock::now();
+    SoupCensus census;
+    census.soups = settings.count;
+
+    std::vector<std::future<SoupTally>> tallies;
+    {
+        ThreadPool pool{settings.threads};
+        // A few chunks per thread keep them all busy until the end.
+        unsigned long chunk = std::max(1ul, settings.count / (pool.size()*8));
+        for(unsigned long first{0u}; first < settings.count; first += chunk){
+            auto last = std::min(settings.count, first + chunk);
+            tallies.push_back(pool.submit([&settings, first, last]{ return run_soups(settings, first, last); }));
+        }
+    }
+
+    std::unordered_map<uint64_t, AshObject> objects;
+    for(auto& future : tallies){
+        auto tally = future.get();
+        census.extinct += tally.extinct;
+        census.stable += tally.stable;
+        census.unstable += tally.unstable;
+        for(const auto& [hash, object] : tally.objects){
+            auto [it, inserted] = objects.try_emplace(hash, object);
+            if(not inserted){
+                it->second.count += object.count;
+                it->second.soup = std::min(it->second.soup, object.soup);
+            }
+        }
+    }
+    for(const auto& [hash, object] : objects){
+        census.objects.push_back(object);
+    }
+    std::sort(census.objects.begin(), census.objects.end(), [](const AshObject& a, const AshObject& b){
+        return a.count > b.count or (a.count == b.count and a.hash < b.hash);
+    });
+
+    census.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return census;
+}
+
+}  // namespace life
@@ -0,0 +1,65 @@
+//! Random soups and the search over them.
+/*!
+ * @file soup.h
+ *
+ * @details Generates random initial tables (soups) and runs many of them
+ * in parallel until they stabilise, tallying the objects left in them
+ * by their canonical hash.
+ */
+
+#ifndef _SOUP_H_
+#define _SOUP_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "escape.h"
+#include "life.h"
+
+namespace life {
+
+/// Parameters of a soup search.
+struct SoupSettings {
+    size_t rows{16};             //!< Rows of each soup.
+    size_t cols{16};             //!< Columns of each soup.
+    double density{0.5};         //!< Probability of each cell starting alive.
+    uint64_t seed{1};            //!< Seed of the whole search; soup `i` is always the same for a given seed.
+    unsigned long count{1000};   //!< How many soups to run.
+    unsigned long max_gen{1000}; //!< Soups not stable by this generation are counted as unstable.
+    size_t threads{0};           //!< Worker threads (zero means one per hardware thread).
+    EscapeSettings escape;       //!< Detection of ships escaping from the soups.
+};
+
+/// An object found in the stabilised soups.
+struct AshObject {
+    uint64_t hash{0};            //!< Canonical hash, the smallest among the phases.
+    std::string name;            //!< Common name, or its kind.
+    unsigned long count{0};      //!< How many times it was found.
+    size_t population{0};        //!< Population of the phase with the smallest hash.
+    unsigned long period{0};     //!< Period of the object (1 for still lifes).
+    unsigned long soup{0};       //!< Index of the first soup it was found in.
+};
+
+/// Result of a soup search.
+struct SoupCensus {
+    unsigned long soups{0};      //!< How many soups were run.
+    unsigned long extinct{0};    //!< Soups that died out.
+    unsigned long stable{0};     //!< Soups that reached a cycle (or a periodic core with escaping ships).
+    unsigned long unstable{0};   //!< Soups still running at max_gen.
+    double seconds{0};           //!< Wall time of the search.
+    std::vector<AshObject> objects; //!< Objects found, most common first.
+};
+
+/// Returns a random soup, where each cell is alive with probability `density`.
+Pattern random_soup(size_t rows, size_t cols, double density, uint64_t seed);
+
+/// Returns the seed of the `index`-th soup of a search with the given seed.
+uint64_t soup_seed(uint64_t seed, unsigned long index);
+
+/// Runs a soup search with the given settings.
+SoupCensus soup_search(const SoupSettings& settings);
+
+}  // namespace life
+
+#endif
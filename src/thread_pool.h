@@ -0,0 +1,87 @@
+//! A fixed size pool of worker threads.
+/*!
+ * @file thread_pool.h
+ *
+ * @details Class ThreadPool, which runs independent tasks on a fixed
+ * number of threads, taking them from a shared queue.
+ */
+
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace life {
+
+/// Runs tasks on a fixed number of worker threads.
+class ThreadPool {
+   public:
+    /// Starts `n_threads` workers; zero means one per hardware thread.
+    explicit ThreadPool(size_t n_threads = 0){
+        if(n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+        for(size_t i{0u}; i < n_threads; i++){
+            m_workers.emplace_back([this]{ work(); });
+        }
+    }
+    /// Finishes the queued tasks and joins the workers.
+    ~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for(auto& worker : m_workers) worker.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Returns how many workers the pool has.
+    size_t size(void) const { return m_workers.size(); }
+
+    /// Queues a task and returns a future for its result.
+    template <typename F>
+    auto submit(F task) -> std::future<decltype(task())> {
+        using result_t = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<result_t()>>(std::move(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock{m_mutex};
+            m_tasks.emplace([packaged]{ (*packaged)(); });
+        }
+        m_cv.notify_one();
+        return future;
+    }
+
+   private:
+    /// Loop of each worker: takes tasks until the pool stops and the queue is empty.
+    void work(void){
+        while(true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock{m_mutex};
+                m_cv.wait(lock, [this]{ return m_stop or not m_tasks.empty(); });
+                if(m_tasks.empty()) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> m_workers;        //!< The worker threads.
+    std::queue<std::function<void()>> m_tasks; //!< Tasks waiting for a worker.
+    std::mutex m_mutex;                        //!< Guards the queue and the stop flag.
+    std::condition_variable m_cv;              //!< Wakes the workers up.
+    bool m_stop{false};                        //!< Set when the pool is being destroyed.
+};
+
+}  // namespace life
+
+#endif
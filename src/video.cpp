@@ -0,0 +1,101 @@
+/**
+ * Raw video output implementation.
+ *
+ */
+
+#include "video.h"
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+#include "../lib/trace.h"
+
+namespace life {
+
+/// The standard output is taken over right away, so nothing printed before the first frame ends up in it.
+VideoWriter::VideoWriter(const VideoSettings& settings) : m_settings{settings} {
+    if(m_settings.command.empty() and m_settings.output == "-"){
+        // The frames keep the standard output to themselves; everything else printed goes to the standard error.
+        std::cout.flush();
+        std::fflush(stdout);
+        int fd = dup(STDOUT_FILENO);
+        if(fd >= 0 and dup2(STDERR_FILENO, STDOUT_FILENO) >= 0) m_file = fdopen(fd, "wb");
+        else m_failed = true;
+    }
+}
+
+VideoWriter::~VideoWriter(){
+    close();
+}
+
+/// Replaces every `{name}` in `text` with `value`.
+static void replace_all(std::string& text, const std::string& name, const std::string& value){
+    for(size_t at = text.find(name); at != std::string::npos; at = text.find(name, at + value.size())){
+        text.replace(at, name.size(), value);
+    }
+}
+
+/// Sizes the buffers and, unless the standard output was taken already, opens the output.
+bool VideoWriter::open(size_t width, size_t height){
+    m_width = width;
+    m_height = height;
+    m_frame.resize(width*height*3);
+    m_indices.resize(width);
+    // A reader going away (the command failing, say) must be an error, not a signal that ends the program.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if(not m_settings.command.empty()){
+        std::string command = m_settings.command;
+        replace_all(command, "{width}", std::to_string(width));
+        replace_all(command, "{height}", std::to_string(height));
+        replace_all(command, "{fps}", std::to_string(m_settings.fps));
+        std::cout.flush();
+        m_file = popen(command.c_str(), "w");
+        m_pipe = true;
+    }
+    else if(m_file == nullptr){
+        m_file = std::fopen(m_settings.output.c_str(), "wb");
+    }
+    return m_file != nullptr;
+}
+
+bool VideoWriter::write(ScanlineSource& source){
+    TRACE_ZONE("video_write");
+    if(m_failed) return false;
+    if(m_frames == 0 and not open(source.width(), source.height())){
+        m_failed = true;
+        return false;
+    }
+    if(source.width() != m_width or source.height() != m_height){
+        m_failed = true;
+        return false;
+    }
+
+    const auto& palette = source.palette();
+    unsigned char* out = m_frame.data();
+    for(size_t y{0u}; y < m_height; y++){
+        source.row(y, m_indices.data());
+        for(size_t x{0u}; x < m_width; x++, out += 3){
+            std::memcpy(out, palette[m_indices[x]].channels, 3);
+        }
+    }
+    if(std::fwrite(m_frame.data(), 1, m_frame.size(), m_file) != m_frame.size()){
+        m_failed = true;
+        return false;
+    }
+    m_frames++;
+    return true;
+}
+
+bool VideoWriter::close(void){
+    if(m_file != nullptr){
+        bool closed = m_pipe ? pclose(m_file) == 0 : std::fclose(m_file) == 0;
+        m_failed = m_failed or not closed;
+        m_file = nullptr;
+    }
+    return not m_failed;
+}
+
+}  // namespace life
@@ -0,0 +1,71 @@
+//! Raw video output of the generations.
+/*!
+ * @file video.h
+ *
+ * @details Each generation is written as a raw RGB24 frame to the standard
+ * output, to a file or named pipe, or to the standard input of a command
+ * (usually ffmpeg), which encodes the video while the simulation goes on,
+ * with no image files in between.
+ */
+
+#ifndef _VIDEO_H_
+#define _VIDEO_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "scanline.h"
+
+namespace life {
+
+/// Settings of the raw video output.
+struct VideoSettings {
+    std::string output{"-"}; //!< Where the frames go without a command: "-" for the standard output, or a file or named pipe.
+    std::string command;     //!< Command started to read the frames from its standard input; {width}, {height} and {fps} are replaced.
+    int fps{30};             //!< Frames per second of the video, for the command.
+};
+
+/// Writes frames of raw RGB24 pixels, row by row, with no header.
+/*!
+ * The output is opened by the first frame, which also sets the size of the
+ * video; every frame after it must have the same size. The frame is built
+ * in a single buffer, reused by every frame, and written at once.
+ *
+ * When the frames go to the standard output, the messages of the program
+ * are moved to the standard error, so they don't get mixed with the video.
+ */
+class VideoWriter {
+   public:
+    explicit VideoWriter(const VideoSettings& settings);
+    /// Calls close().
+    ~VideoWriter();
+    VideoWriter(const VideoWriter&) = delete;
+    VideoWriter& operator=(const VideoWriter&) = delete;
+
+    /// Writes the image of `source` as the next frame. Returns false if it could not be written.
+    bool write(ScanlineSource& source);
+    /// Closes the output, waiting for the command to end. Returns false if any frame or the command failed.
+    bool close(void);
+    /// Returns how many frames were written.
+    size_t frames(void) const { return m_frames; }
+    /// Returns where the frames go, for messages.
+    std::string target(void) const { return m_settings.command.empty() ? m_settings.output : m_settings.command; }
+
+   private:
+    /// Opens the output for frames of the given size.
+    bool open(size_t width, size_t height);
+
+    VideoSettings m_settings;                //!< The settings.
+    FILE* m_file{nullptr};                   //!< The output, once opened.
+    bool m_pipe{false};                      //!< Whether m_file was opened with popen().
+    bool m_failed{false};                    //!< Set once anything fails; no more frames are written.
+    size_t m_width{0}, m_height{0};          //!< Size of the frames.
+    std::vector<Canvas::component_t> m_indices; //!< Palette indices of a row.
+    std::vector<unsigned char> m_frame;      //!< The frame being built, reused by every frame.
+    size_t m_frames{0};                      //!< Frames written.
+};
+
+}  // namespace life
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * Checks that the per generation calls of LifeCfg allocate no memory once
+ * the table is warmed up, by counting the calls of the global operator new.
+ *
+ * Run from the root of the repository, so the patterns in data/ are found.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "life.h"
+
+/// Allocations made so far.
+static size_t allocations{0};
+
+void* operator new(size_t size){
+    allocations++;
+    if(void* p = std::malloc(size > 0 ? size : 1)) return p;
+    throw std::bad_alloc{};
+}
+void* operator new[](size_t size){ return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+/// Generations run before counting: both patterns are periodic (period 60) by then.
+constexpr unsigned WARMUP = 600;
+/// Generations counted.
+constexpr unsigned GENERATIONS = 600;
+
+/// Prints whether `count` allocations were none. Returns false if there were some.
+static bool expect_none(const std::string& pattern, const std::string& what, size_t count){
+    if(count == 0) return true;
+    std::cerr << pattern << ": " << what << " made " << count << " allocations in " << GENERATIONS << " generations\n";
+    return false;
+}
+
+/// Counts the allocations of stepping, reading and drawing `pattern`. Returns false if there were any.
+static bool check(const std::string& pattern){
+    life::Pattern loaded;
+    if(not life::load_pattern(pattern, loaded)){
+        std::cerr << "Cannot load " << pattern << "\n";
+        return false;
+    }
+    life::LifeCfg table{loaded.cells, loaded.rows, loaded.cols};
+    for(unsigned gen{0u}; gen < WARMUP; gen++){
+        table.step();
+        table.set_life_canvas(4, life::BLACK, life::RED);
+    }
+    bool ok{true};
+
+    size_t alive{0}, before{allocations};
+    for(unsigned gen{0u}; gen < GENERATIONS; gen++){
+        table.step();
+        const auto& cells = table.get_alive_cells();
+        alive += cells.size() + table.is_alive(life::Cell(1, 1));
+    }
+    ok = expect_none(pattern, "step() + get_alive_cells() + is_alive()", allocations - before) and ok;
+
+    before = allocations;
+    for(unsigned gen{0u}; gen < GENERATIONS; gen++){
+        table.step();
+        table.set_life_canvas(4, life::BLACK, life::RED);
+    }
+    ok = expect_none(pattern, "step() + set_life_canvas()", allocations - before) and ok;
+
+    // The cells assigned are copied beforehand, so only the assignments are counted.
+    std::vector<std::vector<life::Cell>> generations(GENERATIONS);
+    for(auto& cells : generations){
+        table.step();
+        cells = table.get_alive_cells();
+    }
+    before = allocations;
+    for(auto& cells : generations) table = std::move(cells);
+    ok = expect_none(pattern, "operator=(std::vector<Cell>&&)", allocations - before) and ok;
+
+    return ok and alive > 0;
+}
+
+int main(void){
+    // One size stepped by a FixedBoard, and one by LifeCfg::step_sliced().
+    bool ok = check("data/glider_gun.dat");
+    ok = check("data/glider_gun_large.dat") and ok;
+    std::cout << (ok ? "alloc_test: ok\n" : "alloc_test: FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
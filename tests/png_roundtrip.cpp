@@ -0,0 +1,77 @@
+/**
+ * Checks that the streamed PNG images (stream_png()) decode to the same
+ * pixels as the ones encoded from the canvas (LifeCfg::save_png()).
+ *
+ * Run from the root of the repository, so the patterns in data/ are found.
+ */
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "life.h"
+#include "scanline.h"
+#include "../lib/lodepng.h"
+
+/// Decodes `file` into 8-bit RGB pixels. Returns false if it isn't a valid PNG.
+static bool decode(const std::string& file, std::vector<unsigned char>& pixels, unsigned& width, unsigned& height){
+    pixels.clear();  // lodepng appends to the vector.
+    return lodepng::decode(pixels, width, height, file, LCT_RGB, 8) == 0;
+}
+
+/// Compares the images of generation `gens` of `pattern`, drawn with `block_size` and `view`. Returns false on a mismatch.
+static bool compare(const std::string& pattern, unsigned gens, short block_size, const life::ImageView& view, const std::string& dir){
+    life::Pattern loaded;
+    if(not life::load_pattern(pattern, loaded)){
+        std::cerr << "Cannot load " << pattern << "\n";
+        return false;
+    }
+    life::LifeCfg table{loaded.cells, loaded.rows, loaded.cols};
+    for(unsigned gen{0u}; gen < gens; gen++) table.step();
+
+    table.set_life_canvas(block_size, life::BLACK, life::RED, view);
+    std::vector<unsigned char> expected, streamed;
+    unsigned width, height, streamed_width, streamed_height;
+    if(not table.save_png(dir, "canvas", 6) or not decode(dir + "/canvas.png", expected, width, height)){
+        std::cerr << pattern << ": cannot write or decode the canvas image\n";
+        return false;
+    }
+
+    bool ok{true};
+    for(int level : { 0, 1, 6, 9 }){
+        life::TableScanlines source{table, block_size, life::BLACK, life::RED, view};
+        const std::string file = dir + "/stream.png";
+        if(not life::stream_png(file, source, level) or not decode(file, streamed, streamed_width, streamed_height)){
+            std::cerr << pattern << ", level " << level << ": cannot write or decode the streamed image\n";
+            ok = false;
+        }
+        else if(streamed_width != width or streamed_height != height or streamed != expected){
+            std::cerr << pattern << ", level " << level << ": the streamed image differs from the canvas one\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(void){
+    const std::string dir = (std::filesystem::temp_directory_path() / "glife_png_roundtrip").string();
+    std::filesystem::create_directories(dir);
+
+    life::ImageView whole, part, scaled;
+    part.x = 3;
+    part.y = 2;
+    part.width = 25;
+    part.height = 9;
+    scaled.scale = 3;
+
+    bool ok = compare("data/glider_gun.dat", 30, 4, whole, dir)
+        and compare("data/glider_gun.dat", 30, 3, part, dir)
+        and compare("data/virus_large2.dat", 100, 1, whole, dir)
+        and compare("data/virus_large2.dat", 100, 2, scaled, dir);
+
+    std::filesystem::remove_all(dir);
+    std::cout << (ok ? "png_roundtrip: ok\n" : "png_roundtrip: FAILED\n");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}